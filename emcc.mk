@@ -16,11 +16,20 @@
 CXX = em++
 WEB_DIR = docs
 EXE = $(WEB_DIR)/index.html
-SOURCES = source/backends/impl_emscripten.cpp source/common/model.cpp source/common/io.cpp source/common/shader.cpp source/common/update.cpp source/common/aabb.cpp source/common/ray.cpp source/common/line.cpp
+SOURCES = source/backends/impl_emscripten.cpp source/common/assets.cpp source/common/debug_draw.cpp source/common/embedded.cpp source/common/frame_ring.cpp source/common/frustum.cpp source/common/instancing.cpp source/common/model.cpp source/common/mesh.cpp source/common/mesh_data.cpp source/common/mesh_opt.cpp source/common/obj.cpp source/common/occlusion.cpp source/common/pack.cpp source/common/render_queue.cpp source/common/gom.cpp source/common/io.cpp source/common/shader.cpp source/common/texture.cpp source/common/texture_codec.cpp source/common/gtx.cpp source/common/update.cpp source/common/aabb.cpp source/common/ray.cpp
 SOURCES += source/imgui/imgui.cpp source/imgui/imgui_draw.cpp source/imgui/imgui_tables.cpp source/imgui/imgui_widgets.cpp source/imgui/backends/imgui_impl_sdl.cpp source/imgui/backends/imgui_impl_opengl3.cpp
 OBJS = $(addsuffix .o, $(basename $(notdir $(SOURCES))))
 UNAME_S := $(shell uname -s)
 CPPFLAGS =-DIMGUI_USE_STB_SPRINTF -DIMGUI_DEFINE_MATH_OPERATORS
+# 16-bit positions, half uvs and octahedral normals for every mesh
+#CPPFLAGS += -DQUANTIZE_MESHES
+
+# Meshes, textures, shaders and the font are compiled into the binary by a
+# host build of tools/embed_assets.cpp instead of a separate index.data
+HOST_CXX ?= c++
+EMBED_FILES = models/*.obj assets/*.jpg source/shaders/*.glsl source/imgui/fonts/Roboto-Medium.ttf
+SOURCES += source/generated/embedded_assets.cpp
+CPPFLAGS += -DEMBED_ASSETS
 LDFLAGS =
 EMS =
 
@@ -47,7 +56,7 @@ LDFLAGS += -s NO_FILESYSTEM=1
 CPPFLAGS += -DIMGUI_DISABLE_FILE_FUNCTIONS
 endif
 ifeq ($(USE_FILE_SYSTEM), 1)
-LDFLAGS += -sFULL_ES3 -s MAX_WEBGL_VERSION=2 -s MIN_WEBGL_VERSION=2 --no-heap-copy --preload-file assets/ --preload-file models/ --preload-file source/shaders/ --preload-file source/imgui/fonts/Roboto-Medium.ttf
+LDFLAGS += -sFULL_ES3 -s MAX_WEBGL_VERSION=2 -s MIN_WEBGL_VERSION=2
 endif
 
 ##---------------------------------------------------------------------
@@ -75,6 +84,18 @@ LDFLAGS += --shell-file shell_minimal.html $(EMS)
 %.o:source/imgui/backends/%.cpp
 	$(CXX) $(CPPFLAGS) -c -o $@ $<
 
+%.o:source/generated/%.cpp
+	$(CXX) $(CPPFLAGS) -c -o $@ $<
+
+EMBED_SOURCES = tools/embed_assets.cpp source/common/embedded.cpp source/common/pack.cpp source/common/mesh_data.cpp source/common/obj.cpp source/common/mesh_opt.cpp source/common/gom.cpp source/common/io.cpp source/common/gtx.cpp source/common/texture_codec.cpp
+
+embed-assets: $(EMBED_SOURCES)
+	$(HOST_CXX) -o $@ $^ -Iinclude -Isource/imgui -Wall -Wextra -std=c++17 -O2 -pthread $(filter -DQUANTIZE_MESHES,$(CPPFLAGS))
+
+source/generated/embedded_assets.cpp: embed-assets $(wildcard $(EMBED_FILES))
+	mkdir -p source/generated
+	./embed-assets -t etc2 -t bc1 $@ $(EMBED_FILES)
+
 all: $(EXE)
 	@echo Build complete for $(EXE)
 
@@ -88,4 +109,4 @@ $(EXE): $(OBJS) $(WEB_DIR)
 	$(CXX) -o $@ $(OBJS) $(LDFLAGS)
 
 clean:
-	rm -rf $(OBJS) $(WEB_DIR)
+	rm -rf $(OBJS) $(WEB_DIR) embed-assets source/generated
@@ -10,18 +10,8 @@ struct AABB
     glm::vec3 max;
 };
 
-struct Box
-{
-    unsigned int VBO, VAO;
-    std::vector<float> vertices;
-
-    Box(AABB b);
-    ~Box();
-
-    void draw();
-    void update(AABB const &b);
-};
-
 bool intersect(AABB const &a, AABB const &b);
 bool intersect(glm::vec3 const &point, AABB const &box);
 AABB calc_transformed_bounds(AABB const &b, glm::mat4 const &transform);
+// Largest side of the box on screen in pixels, INFINITY when it reaches behind the camera
+float projected_size(AABB const &b, glm::mat4 const &view_projection, int width, int height);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <functional>
+#include <stddef.h>
+
+#include "gl_base.hpp"
+
+// Time spent uploading finished assets each frame
+#define ASSET_UPLOAD_BUDGET_MS 2.0
+// Bytes moved per upload step, small enough to stay inside the budget
+#define ASSET_UPLOAD_CHUNK (1 << 20)
+// Pixel unpack buffers cycled by texture uploads
+#define ASSET_STAGING_BUFFERS 4
+
+enum AssetStep
+{
+    ASSET_STEP_MORE, // call again
+    ASSET_STEP_DONE,
+    ASSET_STEP_WAIT, // blocked on the GPU, retry next frame
+};
+
+// Runs on the GL thread until it is done, each call should move at most
+// ASSET_UPLOAD_CHUNK bytes so a big asset spreads over several frames
+typedef std::function<AssetStep()> AssetUpload;
+// Runs on a worker, must not touch GL, returns the upload for its result
+typedef std::function<AssetUpload()> AssetLoad;
+
+// A buffer filled a chunk at a time, see upload_step
+struct BufferUpload
+{
+    GLenum target;
+    GLuint buffer;
+    const void *data;
+    size_t size;
+    size_t offset;
+};
+
+void assets_init();
+void assets_shutdown();
+void queue_asset(AssetLoad load);
+// Uploads finished loads until budget_ms is spent, returns how many completed
+int upload_assets(double budget_ms = ASSET_UPLOAD_BUDGET_MS);
+size_t assets_pending();
+
+// Creates target's storage on the first call, returns true once it is filled
+bool upload_step(BufferUpload &upload);
+
+// Copies data into a staging buffer the GPU is done with and leaves it
+// bound to GL_PIXEL_UNPACK_BUFFER, so the following glTex*SubImage call
+// sources offset 0 and returns without waiting for the transfer. False
+// while every staging buffer is still in flight.
+bool staging_begin(const void *data, size_t size);
+// Fences the staging buffer after its upload was issued and unbinds it
+void staging_end();
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "aabb.hpp"
+#include "gl_base.hpp"
+#include "ray.hpp"
+
+struct DebugVertex
+{
+    glm::vec3 position;
+    uint32_t color; // RGBA8, location 1
+};
+
+// Immediate mode lines, appended to one vertex stream over the frame and
+// drawn together by debug_flush. Cheap enough to call for every model.
+void debug_line(glm::vec3 const &start, glm::vec3 const &end, glm::vec4 const &color = glm::vec4(1.0f));
+void debug_aabb(AABB const &box, glm::vec4 const &color = glm::vec4(1.0f));
+void debug_ray(Ray const &ray, float length, glm::vec4 const &color = glm::vec4(1.0f));
+// Draws every line since the last flush with a single glDrawArrays, using
+// the Frame uniform block already bound, and starts over. Leaves no
+// program bound.
+void debug_flush();
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Files compiled into the binary by tools/embed_assets.cpp. Meshes are
+// stored as their .gom cache and textures as their .gtx cache, under the
+// same path the loaders would look for on disk.
+struct EmbeddedFile
+{
+    const char *path;
+    const uint8_t *data;
+    size_t size;
+};
+
+// Sorted by path, empty unless built with EMBED_ASSETS
+extern const EmbeddedFile embedded_files[];
+extern const size_t embedded_file_count;
+
+// NULL when path was not embedded
+EmbeddedFile const *find_embedded(const char *path);
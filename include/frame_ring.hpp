@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gl_base.hpp"
+
+// Frames the GPU may be behind before frame_ring_begin waits
+#define FRAME_RING_FRAMES 3
+// Starting bytes per frame, doubled whenever a frame runs out
+#define FRAME_RING_SIZE (4 << 20)
+
+// Part of the ring written once and read by the GPU this frame only
+struct FrameSpan
+{
+    GLuint buffer;
+    size_t offset; // into buffer, for attribute pointers and glBindBufferRange
+    size_t size;
+    uint8_t *data;
+};
+
+// One buffer for every piece of per-frame dynamic data: instances, debug
+// vertices and uniform blocks. With ARB_buffer_storage it is mapped
+// persistently once, split into FRAME_RING_FRAMES regions and each
+// frame's region is fenced. Otherwise (ES3, WebGL) it is orphaned every
+// frame and spans are written through a CPU copy.
+//
+// Waits for the region about to be reused
+void frame_ring_begin();
+// Fences the region of the frame that just ended
+void frame_ring_end();
+// alignment must be a power of two. A span is only valid until the next
+// frame_alloc, write and flush it before asking for another.
+FrameSpan frame_alloc(size_t size, size_t alignment = 16);
+// Hands what was written to span over to the GPU, only copies without a
+// persistent mapping
+void frame_flush(FrameSpan const &span);
+// frame_alloc, copy and frame_flush in one
+FrameSpan frame_push(const void *data, size_t size, size_t alignment = 16);
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, for spans bound to uniform blocks
+size_t uniform_alignment();
+// Pushes a uniform block's contents and binds them to binding
+void frame_uniforms(GLuint binding, const void *data, size_t size);
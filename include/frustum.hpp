@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "aabb.hpp"
+
+// Left, right, bottom, top, near and far planes as (normal, distance),
+// a point p is inside when dot(normal, p) + distance >= 0 for all six
+struct Frustum
+{
+    glm::vec4 planes[6];
+};
+
+// Box bounds as structure of arrays, padded to a multiple of four so the
+// test reads four boxes per step
+struct PackedBounds
+{
+    std::vector<float> min_x, min_y, min_z;
+    std::vector<float> max_x, max_y, max_z;
+    size_t count = 0;
+
+    void clear();
+    void push(AABB const &box);
+};
+
+Frustum extract_frustum(glm::mat4 const &view_projection);
+// Replaces visible with the indices of every box inside or crossing the
+// frustum. Conservative, a box outside near a corner may still pass.
+void cull_frustum(Frustum const &frustum, PackedBounds const &bounds, std::vector<uint32_t> &visible);
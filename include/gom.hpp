@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "io.hpp"
+#include "mesh_opt.hpp"
+
+// .gom is the binary mesh cache written next to a source OBJ. The
+// interleaved vertices and the indices follow the header at GOM_ALIGNMENT
+// aligned offsets so they can be handed to glBufferData straight from the
+// mapping.
+#define GOM_MAGIC 0x314D4F47 // "GOM1"
+#define GOM_VERSION 4
+#define GOM_ALIGNMENT 16
+#define GOM_MAX_LODS MESH_MAX_LODS
+
+// GomHeader::flags, the processing that was applied to the streams
+#define GOM_FLAG_OPTIMIZED (1 << 0)
+#define GOM_FLAG_QUANTIZED (1 << 1) // unorm16x4 positions in bounds, half2 uvs, octahedral snorm16x2 normals
+#define GOM_FLAG_LODS (1 << 2)      // simplified index ranges follow the full one
+
+struct GomHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t source_hash;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t index_size; // 2 or 4 bytes
+    uint32_t flags;
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max;
+    // largest error measured when quantizing, 0 for float streams
+    float position_error;
+    float uv_error;
+    float normal_error; // degrees
+    uint32_t lod_count;
+    MeshLod lods[GOM_MAX_LODS];
+    uint32_t vertex_stride;
+    uint64_t vertices_offset;
+    uint64_t indices_offset;
+};
+
+struct GomSource
+{
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash; // 0 until the source has been read
+};
+
+// Bytes of each attribute for the given flags, interleaved as position,
+// normal, uv
+struct GomLayout
+{
+    uint32_t position_size;
+    uint32_t uv_size;
+    uint32_t normal_size;
+    uint32_t normal_offset;
+    uint32_t uv_offset;
+    uint32_t stride;
+};
+
+struct GomStreams
+{
+    uint32_t vertex_count;
+    void const *vertices; // interleaved as in GomLayout
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max;
+    float position_error;
+    float uv_error;
+    float normal_error;
+};
+
+struct GomMesh
+{
+    File file; // unmapped when the cache came from gom_parse
+    GomHeader const *header;
+    void const *vertices;
+    void const *indices;
+};
+
+GomLayout gom_layout(uint32_t flags);
+// Packs separate attribute arrays laid out per gom_layout(flags) into out
+void gom_interleave(uint32_t flags, size_t vertex_count, const void *positions, const void *normals, const void *uvs, std::vector<uint8_t> &out);
+
+uint64_t gom_hash(const uint8_t *data, size_t size);
+bool gom_source_info(const char *source_path, GomSource &source);
+// Whether a cache built from a source of size, mtime and hash still matches it
+bool gom_source_matches(const char *source_path, GomSource const &source, uint64_t size, int64_t mtime, uint64_t hash);
+// Writes mtime at offset into the cache at path once its source matched
+// by hash, so later opens don't read the whole source again
+bool gom_stamp_mtime(const char *path, size_t offset, int64_t mtime);
+// Points mesh into a cache already in memory, without checking its source
+bool gom_parse(const uint8_t *data, size_t size, uint32_t flags, GomMesh &mesh);
+bool gom_open(const char *path, const char *source_path, GomSource const &source, uint32_t flags, GomMesh &mesh);
+void gom_close(GomMesh &mesh);
+bool gom_write(const char *path, GomSource const &source, uint32_t flags, GomStreams const &streams,
+               std::vector<uint32_t> const &indices, std::vector<MeshLod> const &lods);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "gom.hpp"
+#include "io.hpp"
+#include "texture_codec.hpp"
+
+// .gtx is the GPU texture cache written next to a source image, one file
+// per format. Every mip level sits at a GTX_ALIGNMENT aligned offset so
+// it can be handed to glCompressedTexImage2D straight from the mapping.
+#define GTX_MAGIC 0x31585447 // "GTX1"
+#define GTX_VERSION 1
+#define GTX_ALIGNMENT 16
+#define GTX_MAX_LEVELS 16
+
+struct GtxLevel
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct GtxHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t source_hash;
+    uint32_t format; // TextureFormat
+    uint32_t level_count;
+    GtxLevel levels[GTX_MAX_LEVELS];
+};
+
+struct GtxTexture
+{
+    File file; // unmapped when the cache came from gtx_parse
+    GtxHeader const *header;
+    const uint8_t *data;
+};
+
+std::string gtx_cache_path(const char *source_path, TextureFormat format);
+// Points texture into a cache already in memory, without checking its source
+bool gtx_parse(const uint8_t *data, size_t size, TextureFormat format, GtxTexture &texture);
+bool gtx_open(const char *path, const char *source_path, GomSource const &source, TextureFormat format, GtxTexture &texture);
+void gtx_close(GtxTexture &texture);
+const uint8_t *gtx_level_data(GtxTexture const &texture, uint32_t level);
+// Encodes every RGB8 level into format while writing
+bool gtx_write(const char *path, GomSource const &source, TextureFormat format, std::vector<TextureLevel> const &levels);
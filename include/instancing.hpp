@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "gl_base.hpp"
+#include "shader.hpp"
+
+// Defines of the programs models are drawn with, see RenderQueue
+#define INSTANCED_DEFINES "#define INSTANCED\n"
+
+// Per instance attributes, the matrix takes locations 3 to 6
+struct InstanceData
+{
+    glm::mat4 matrix; // model matrix with dequantization folded in
+    glm::vec4 color;  // location 7
+    float layer;      // location 8, texture array layer
+};
+
+// Points the instance attributes of the bound vertex array at the
+// instance starting offset bytes into buffer
+void bind_instances(GLuint buffer, size_t offset);
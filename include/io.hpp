@@ -90,8 +90,11 @@ File open_and_map_file(const char *path, flag_t access);
 File create_and_map_file(const char *path, flag_t access);
 int close_file(File f);
 int file_exists(const char *path);
+// Succeeds when it already exists
+int create_directory(const char *path);
 int truncate_file(File *f, size_t new_size);
 int get_file_size(File *f);
+int get_file_info(const char *path, uint64_t *size, int64_t *mtime);
 int map_file(File *f);
 int unmap_file(File f);
 int unmap_and_close_file(File f);
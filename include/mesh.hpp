@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "aabb.hpp"
+#include "gl_base.hpp"
+#include "mesh_data.hpp"
+
+// A level may be drawn once its error covers less than this many pixels
+#define MESH_LOD_PIXEL_ERROR 1.0f
+
+// GPU buffers plus the single CPU copy of a mesh, shared by every Model
+// drawing it. Meshes loaded from a path are registered by that path and
+// their load flags, and freed once the last Model referencing them is gone.
+struct Mesh
+{
+    std::string path;
+    std::string key; // in the registry, empty when not loaded from a path
+    uint32_t id; // never reused, for render queue keys
+    GLuint vertex_buffer = 0; // position, normal and uv interleaved
+    GLuint element_buffer = 0;
+    // every attribute and the element buffer, bound once per draw
+    GLuint vertex_array = 0;
+    GLenum index_type;
+    uint32_t flags = 0;
+    // false while an async load still shows the placeholder cube
+    bool loaded = true;
+    // applied before the model matrix, undoes position quantization
+    glm::mat4 dequantize = glm::mat4(1.0f);
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<uint32_t> indices; // every level, lods[0] is the full mesh
+    std::vector<MeshLod> lods;
+    AABB bounds;
+
+    // Unit cube standing in until an async load arrives
+    Mesh();
+    Mesh(MeshData const &data);
+    Mesh(Mesh const &) = delete;
+    Mesh &operator=(Mesh const &) = delete;
+    ~Mesh();
+
+    // Coarsest level whose error stays under MESH_LOD_PIXEL_ERROR at screen_size pixels
+    MeshLod const &select_lod(float screen_size) const;
+    // Takes over buffers filled from data, dropping the current ones
+    void replace(GLuint vertex_buffer, GLuint element_buffer, MeshData const &data);
+
+private:
+    void assign(MeshData const &data);
+    void build_vertex_array();
+};
+
+std::shared_ptr<Mesh> load_mesh(const char *path, uint32_t flags = MESH_DEFAULT_FLAGS);
+// Returns at once with a placeholder that is filled in by upload_assets
+std::shared_ptr<Mesh> load_mesh_async(const char *path, uint32_t flags = MESH_DEFAULT_FLAGS);
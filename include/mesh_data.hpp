@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "gom.hpp"
+#include "mesh_opt.hpp"
+
+// load_mesh flags
+#define MESH_OPTIMIZE GOM_FLAG_OPTIMIZED // reorder for the vertex cache and fetch locality
+#define MESH_QUANTIZE GOM_FLAG_QUANTIZED // 16-bit positions, half uvs, octahedral normals
+#define MESH_LODS GOM_FLAG_LODS          // simplified levels of detail
+#ifdef QUANTIZE_MESHES
+#define MESH_DEFAULT_FLAGS (MESH_OPTIMIZE | MESH_LODS | MESH_QUANTIZE)
+#else
+#define MESH_DEFAULT_FLAGS (MESH_OPTIMIZE | MESH_LODS)
+#endif // QUANTIZE_MESHES
+
+// CPU half of a mesh load. Built without GL so a worker can make it,
+// streams point either into the cache mapping or the vectors below.
+struct MeshData
+{
+    uint32_t flags = 0;
+    GomStreams streams = {};
+    const void *index_data = NULL;
+    uint32_t index_size = 4;
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+
+    GomMesh cached = {};
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<uint16_t> short_indices;
+    QuantizedStreams quantized;
+    std::vector<uint8_t> interleaved;
+
+    MeshData() = default;
+    MeshData(MeshData const &) = delete;
+    MeshData &operator=(MeshData const &) = delete;
+    ~MeshData();
+};
+
+// Reads path through its .gom cache, parsing and writing it when stale.
+// False when neither can be read, it only logs so workers may call it.
+bool read_mesh_data(const char *path, uint32_t flags, MeshData &data);
+// Points streams at the float vectors, or their quantized copies
+void fill_streams(MeshData &data);
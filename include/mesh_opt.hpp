@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+struct VertexCacheStats
+{
+    float acmr; // transformed vertices per triangle, 0.5 is ideal for a grid
+    float atvr; // transformed vertices per vertex, 1.0 is ideal
+};
+
+// Simulates a FIFO post-transform cache of cache_size entries
+VertexCacheStats analyze_vertex_cache(std::vector<uint32_t> const &indices, size_t vertex_count, unsigned cache_size = 16);
+// Reorders triangles for the post-transform cache (Forsyth's linear-speed algorithm)
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count);
+// Renumbers vertices in order of first use so fetches walk memory linearly
+void optimize_vertex_fetch(std::vector<uint32_t> &indices, std::vector<glm::vec3> &vertices, std::vector<glm::vec2> &uvs, std::vector<glm::vec3> &normals);
+
+#define MESH_MAX_LODS 5
+#define MESH_LOD_RATIO 0.5f     // triangles kept from one level to the next
+#define MESH_LOD_MAX_ERROR 0.1f // no collapse may move the surface further, relative to the extent
+
+// A range of the index buffer, every level shares the same vertices
+struct MeshLod
+{
+    uint32_t index_offset;
+    uint32_t index_count;
+    float error; // largest deviation from the full mesh relative to its extent
+};
+
+// Appends quadric error simplified levels after the full index list in
+// indices, each with about MESH_LOD_RATIO of the previous level's triangles.
+// UV seams and open borders are kept in place. Stops early once a level
+// barely shrinks, lods always starts with the full mesh.
+void build_lods(std::vector<uint32_t> &indices, std::vector<glm::vec3> const &vertices, std::vector<MeshLod> &lods, unsigned max_lods = MESH_MAX_LODS);
+
+struct QuantizedStreams
+{
+    std::vector<glm::u16vec4> positions; // unorm16 within the bounds, w unused
+    std::vector<uint32_t> uvs;           // packHalf2x16
+    std::vector<uint32_t> normals;       // packSnorm2x16 of the octahedral mapping
+    float position_error;                // largest component error in object units
+    float uv_error;
+    float normal_error; // degrees
+};
+
+void quantize_streams(std::vector<glm::vec3> const &vertices, std::vector<glm::vec2> const &uvs, std::vector<glm::vec3> const &normals,
+                      glm::vec3 const &min, glm::vec3 const &max, QuantizedStreams &out);
+void dequantize_streams(size_t vertex_count, glm::u16vec4 const *positions, uint32_t const *uvs, uint32_t const *normals, glm::vec3 const &min, glm::vec3 const &max,
+                        std::vector<glm::vec3> &out_vertices, std::vector<glm::vec2> &out_uvs, std::vector<glm::vec3> &out_normals);
+// Maps unorm16 positions, as the vertex shader sees them, back into the bounds
+glm::mat4 dequantize_matrix(glm::vec3 const &min, glm::vec3 const &max);
@@ -2,30 +2,29 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "aabb.hpp"
 #include "gl_base.hpp"
+#include "mesh.hpp"
+#include "occlusion.hpp"
 #include "shader.hpp"
+#include "texture.hpp"
 
 struct Model
 {
-    GLuint program_id = 0;
-    GLuint matrix_id;
-    GLuint time_id;
-    GLuint color_id;
-    GLuint texture_id = 0;
-    GLuint uv_buffer = 0;
-    GLuint vertex_buffer;
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec2> uvs;
-    std::vector<glm::vec3> normals;
+    Program *program; // instanced, the render queue draws every model that way
+    std::shared_ptr<Mesh> mesh;
+    std::shared_ptr<Texture> texture;
     glm::mat4 matrix = glm::mat4(1.0f);
     glm::vec4 color = {1.0f, 0.0f, 1.0f, 1.0f};
     AABB box;
     AABB original_box;
 
+    OcclusionQuery occlusion;
+
     // arrows
     bool drag = false;
 
@@ -33,11 +32,13 @@ struct Model
     glm::vec3 rotation = {0.0f, 0.0f, 0.0f};
     const char *label;
 
-    Model(GLuint matrix_id, GLuint color_id, std::vector<glm::vec3> const &vertices, std::vector<glm::vec2> const &uvs, std::vector<glm::vec3> const &normals, const char *label = "");
-    static Model *from_obj(GLuint matrix_id, GLuint color_id, const char *path, const char *label = "");
+    Model(Program *program, std::shared_ptr<Mesh> mesh, const char *label = "");
+    static Model *from_obj(Program *program, const char *path, const char *label = "");
     void move_to(glm::vec3 const &coords);
     void move_by(glm::vec3 const &coords);
-    void draw(glm::mat4 const &view_projection);
+    MeshLod const &select_lod(glm::mat4 const &view_projection) const;
+    // Picks up new mesh bounds once an async load has replaced the placeholder
+    void refresh_box();
     void texture_from_file(const char *path);
 };
 
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Indices are resolved to 0-based positions in ObjData, -1 means the
+// component was not present in the face record.
+struct ObjCorner
+{
+    int32_t v;
+    int32_t vt;
+    int32_t vn;
+};
+
+struct ObjData
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners; // 3 per triangle, polygons are fanned
+};
+
+struct ObjCounts
+{
+    size_t positions;
+    size_t uvs;
+    size_t normals;
+    size_t corners;
+    size_t lines;
+};
+
+// Files smaller than this per thread are not worth splitting
+#define OBJ_MIN_CHUNK_SIZE (1 << 20)
+
+ObjCounts count_obj(const uint8_t *data, size_t size);
+bool parse_obj(const uint8_t *data, size_t size, ObjData &obj);
+// Same output as parse_obj, threads == 0 uses every core
+bool parse_obj_parallel(const uint8_t *data, size_t size, ObjData &obj, unsigned threads = 0);
+// hash, when given, receives gom_hash of the file contents
+bool load_obj(const char *path, ObjData &obj, uint64_t *hash = 0);
+// Builds one vertex per unique v/vt/vn triple and an index per corner
+void weld_obj(ObjData const &obj, std::vector<glm::vec3> &vertices, std::vector<glm::vec2> &uvs, std::vector<glm::vec3> &normals, std::vector<uint32_t> &indices);
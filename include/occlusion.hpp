@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "gl_base.hpp"
+
+// Frames a visible model goes without being tested again, models are
+// staggered so about this fraction of them is tested each frame.
+// Occluded ones are tested every frame so they reappear quickly.
+#define OCCLUSION_VISIBLE_INTERVAL 4
+
+struct Model;
+
+// Per model state of its box proxy's occlusion query
+struct OcclusionQuery
+{
+    GLuint id = 0;
+    bool pending = false;  // issued, result not read back yet
+    bool visible = true;   // last result read back
+    uint32_t seen = 0;     // last frame the model was in view
+    uint32_t issued = 0;   // scene version the pending query was issued at
+    uint32_t measured = 0; // scene version of the last result read back
+};
+
+// Reads back every finished query of the models in view and keeps the
+// indices of those not known to be occluded in drawn. Never waits on the GPU,
+// results arrive a frame or more after they were issued. scene is bumped
+// whenever what is on screen changes. True while a visibility flipped or an
+// occluded model has no result measured at this scene yet, the frames after
+// should still be drawn so late results aren't lost.
+bool occlusion_cull(Model *const *models, std::vector<uint32_t> const &in_view, std::vector<uint32_t> &drawn, glm::vec3 const &eye, uint32_t scene);
+// Renders the box proxies of the models due for a test against the depth
+// buffer as it is, so call it after opaque models are drawn. Leaves no
+// program bound.
+void occlusion_query(Model *const *models, std::vector<uint32_t> const &in_view, glm::mat4 const &view_projection, glm::vec3 const &eye, uint32_t scene);
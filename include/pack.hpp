@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// .gpk packs many assets into one file: a header, an open addressing
+// table of entries hashed by path, the path strings, then the blobs at
+// GPK_ALIGNMENT aligned offsets. Blobs are stored as is, so they are read
+// straight from the mapping, or LZ4 block compressed when that saves
+// enough and the loader copies them anyway.
+#define GPK_MAGIC 0x314B5047 // "GPK1"
+#define GPK_VERSION 1
+#define GPK_ALIGNMENT 16
+#define GPK_EMPTY 0xFFFFFFFF
+// mounted at startup when present, see `make pack`
+#define GPK_DEFAULT_PATH "assets.gpk"
+
+// GpkEntry::compression
+#define GPK_STORED 0
+#define GPK_LZ4 1
+
+struct GpkHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t slot_count; // power of two, each slot an entry index or GPK_EMPTY
+    uint64_t slots_offset;
+    uint64_t entries_offset;
+    uint64_t paths_offset;
+};
+
+struct GpkEntry
+{
+    uint64_t hash;
+    uint32_t path_offset; // from paths_offset, not terminated
+    uint32_t path_size;
+    uint64_t offset;
+    uint64_t size; // as stored
+    uint64_t raw_size;
+    uint32_t compression;
+    uint32_t reserved;
+};
+
+struct PackInput
+{
+    std::string path;
+    const uint8_t *data;
+    size_t size;
+    bool compress; // only kept when it saves a quarter or more
+};
+
+// A read only view of an asset that stays valid until the pack is unmounted
+struct AssetSpan
+{
+    const uint8_t *data;
+    size_t size;
+};
+
+bool pack_write(const char *path, std::vector<PackInput> const &inputs);
+
+// Maps path once for every later find_packed, false when it is missing or invalid
+bool pack_mount(const char *path);
+void pack_unmount();
+// Looks in the mounted pack, then in the files embedded in the binary.
+// Safe to call from asset workers.
+bool find_packed(const char *path, AssetSpan &span);
+
+// LZ4 block format. lz4_compress returns the compressed size,
+// lz4_decompress fails unless dst_size bytes come out exactly.
+size_t lz4_compress(const uint8_t *src, size_t size, std::vector<uint8_t> &dst);
+bool lz4_decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_size);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "frame_ring.hpp"
+#include "model.hpp"
+
+// Highest two bits of a sort key, drawn in this order
+enum RenderLayer
+{
+    RENDER_OPAQUE,
+    RENDER_TRANSPARENT, // back to front, no depth writes
+    RENDER_OVERLAY,     // after the depth buffer is cleared
+};
+
+// Below the layer, opaque and overlay keys hold
+//     61-52 program, 51-40 texture array, 39-20 mesh, 19-16 level of detail
+// and transparent keys
+//     61-30 distance from the eye, inverted so the farthest sorts first,
+//     29-20 program, 19-0 mesh
+struct RenderItem
+{
+    uint64_t key;
+    Model *model;
+    uint32_t lod;
+};
+
+// Every model drawn in a frame, radix sorted by key and drawn with one
+// glDrawElementsInstanced per run of items sharing program, texture,
+// mesh and level of detail. Only state that differs from the run before
+// is bound.
+struct RenderQueue
+{
+    std::vector<RenderItem> items;
+
+    void clear();
+    // Opaque or transparent by the model's alpha unless overlay
+    void push(Model *model, glm::mat4 const &view_projection, bool overlay = false);
+    void sort();
+    // Draws the items of layers first to last with the Frame uniform block
+    // already bound. The first call after sort writes every item's instance
+    // data into the frame ring. Leaves no program bound and depth writes on.
+    void execute(RenderLayer first = RENDER_OPAQUE, RenderLayer last = RENDER_OVERLAY);
+
+private:
+    std::vector<RenderItem> scratch;
+    bool uploaded = false;
+    FrameSpan instances;
+};
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
 #ifdef __EMSCRIPTEN__
 #include <SDL_opengles2.h>
 #else
@@ -7,5 +11,59 @@
 #include <GLFW/glfw3.h>
 #endif // __EMSCRIPTEN__
 
-void compile_shader(GLuint shader_id, void *shader_source);
-GLuint load_shaders(const char *vertex_path, const char *fragment_path);
+#include <glm/glm.hpp>
+
+// Uniform block bindings, set on every program by finish_program
+#define FRAME_BLOCK_BINDING 0
+#define OBJECT_BLOCK_BINDING 1
+
+// std140 layout of the Frame block, bound once per frame
+struct FrameConstants
+{
+    glm::mat4 view_projection;
+};
+
+// std140 layout of the Object block, a range of it bound per draw
+struct ObjectConstants
+{
+    glm::mat4 mvp;
+    glm::vec4 color;
+    float layer;
+    float padding[3];
+};
+
+// A program whose compile and link may still be running in the driver.
+// Status is only queried and uniform blocks bound once it is finished.
+struct Program
+{
+    std::string vertex_path;
+    std::string fragment_path;
+    std::string defines;
+    GLuint id = 0;
+    uint32_t index = 0; // in request order, for render queue keys
+    bool finished = false;
+
+    // until finished
+    GLuint vertex_shader = 0;
+    GLuint fragment_shader = 0;
+    std::string cache_path; // empty without program binaries
+    uint64_t driver_hash = 0;
+    uint64_t source_hash = 0;
+};
+
+// defines are inserted after the #version line, e.g. "#define INSTANCED\n"
+void compile_shader(GLuint shader_id, const char *source, size_t size, const char *defines = "");
+// Starts compiling and linking without waiting and returns at once. The
+// same Program is shared by every request for (vertex_path, fragment_path,
+// defines). On desktop the program binary is also kept in a .gpb file
+// under shader_cache, so later runs skip compiling while the driver and
+// sources stay the same.
+Program *request_program(const char *vertex_path, const char *fragment_path, const char *defines = "");
+// Finishes every program the driver reports done, never blocks. Only does
+// anything with KHR/ARB_parallel_shader_compile.
+void poll_programs();
+// Blocks until program is linked, the first time only
+void finish_program(Program &program);
+void use_program(Program &program);
+// request_program and finish_program in one
+GLuint load_shaders(const char *vertex_path, const char *fragment_path, const char *defines = "");
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gl_base.hpp"
+#include "texture_codec.hpp"
+
+// Layers per GL_TEXTURE_2D_ARRAY, a full array starts another one
+#define TEXTURE_ARRAY_LAYERS 8
+
+// Textures of one size, format and mip count packed as layers of a single
+// array texture, so models using any of them bind the same GL name
+struct TextureArray
+{
+    GLuint id = 0;
+    TextureFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    std::vector<char> used;
+
+    TextureArray(TextureFormat format, uint32_t width, uint32_t height, uint32_t levels, uint32_t layers);
+    TextureArray(TextureArray const &) = delete;
+    TextureArray &operator=(TextureArray const &) = delete;
+    ~TextureArray();
+
+    // -1 when every layer is taken
+    int allocate();
+    void release(uint32_t layer);
+};
+
+// A mipmapped texture decoded once per path and shared by every Model
+// using it. It samples a white placeholder layer until the async decode
+// has been uploaded into its own layer.
+struct Texture
+{
+    std::string path;
+    std::shared_ptr<TextureArray> array;
+    uint32_t layer = 0;
+    int width = 1;
+    int height = 1;
+    bool loaded = false;
+
+    Texture();
+    Texture(Texture const &) = delete;
+    Texture &operator=(Texture const &) = delete;
+    ~Texture();
+};
+
+// Bit per TextureFormat the context samples, TEXTURE_RGB8 is always there
+uint32_t texture_formats();
+// Best block compressed format the context samples, TEXTURE_RGB8 when none
+TextureFormat texture_format();
+// Loads through the .gtx cache for texture_format(), building it when stale
+std::shared_ptr<Texture> load_texture(const char *path);
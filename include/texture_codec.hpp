@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Pixel formats a texture can be built into, also stored in .gtx files
+enum TextureFormat : uint32_t
+{
+    TEXTURE_RGB8 = 0,  // uncompressed, 24 bits per pixel
+    TEXTURE_BC1 = 1,   // S3TC DXT1, 4 bits per pixel, desktop
+    TEXTURE_ETC2 = 2,  // ETC2 RGB8 (ETC1 subset), 4 bits per pixel, ES3 and WebGL
+};
+
+struct TextureLevel
+{
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> pixels; // tightly packed RGB8
+};
+
+// Box filtered mip chain down to 1x1, averaging in linear light. levels[0] is the image itself.
+void build_mips(const uint8_t *rgb, uint32_t width, uint32_t height, std::vector<TextureLevel> &levels);
+
+size_t texture_level_size(TextureFormat format, uint32_t width, uint32_t height);
+// Encodes an RGB8 image, 4x4 blocks in rows, partial blocks padded by clamping
+void encode_texture(TextureFormat format, const uint8_t *rgb, uint32_t width, uint32_t height, uint8_t *out);
+// Back to RGB8, for GPUs without the format and for measuring the encoders
+void decode_texture(TextureFormat format, const uint8_t *data, uint32_t width, uint32_t height, uint8_t *rgb);
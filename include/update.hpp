@@ -4,6 +4,10 @@
 
 #include "model.hpp"
 
+// Frames still drawn after the last change so ImGui settles, occlusion
+// results keep it drawing for longer while they are outstanding
+#define REDRAW_FRAMES 3
+
 extern float horizontal_angle;
 extern float vertical_angle;
 extern float speed;
@@ -13,5 +17,11 @@ extern std::vector<Model *> arrows;
 extern Model *selected_model;
 
 void graph_ops_init();
-void graph_ops_update(double ticks, double dt);
+// For anything that changes what is on screen outside graph_ops_update,
+// such as input or a resized window
+void mark_dirty();
+// Steps the camera and models, then draws unless nothing changed for
+// REDRAW_FRAMES frames. False when nothing was drawn, the backend should
+// then skip ImGui and the swap and wait for input.
+bool graph_ops_update(double dt);
 void imgui_update();
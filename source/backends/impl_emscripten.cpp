@@ -3,6 +3,7 @@
 #include "imgui_impl_sdl.h"
 
 #include "impl_base.hpp"
+#include "pack.hpp"
 #include "shader.hpp"
 #include "update.hpp"
 
@@ -113,8 +114,17 @@ int main(int, char **)
     font_cfg.SizePixels = 22.0f;
     io.Fonts->AddFontDefault(&font_cfg);
 
+    const char *font_path = "source/imgui/fonts/Roboto-Medium.ttf";
+    AssetSpan font;
+    if (find_packed(font_path, font))
+    {
+        ImFontConfig embedded_cfg;
+        embedded_cfg.FontDataOwnedByAtlas = false;
+        io.Fonts->AddFontFromMemoryTTF((void *)font.data, (int)font.size, 16.0f, &embedded_cfg);
+    }
 #ifndef IMGUI_DISABLE_FILE_FUNCTIONS
-    io.Fonts->AddFontFromFileTTF("source/imgui/fonts/Roboto-Medium.ttf", 16.0f);
+    else
+        io.Fonts->AddFontFromFileTTF(font_path, 16.0f);
 #endif
 
     graph_ops_init();
@@ -143,7 +153,9 @@ static void main_loop(void *arg)
     now = SDL_GetPerformanceCounter();
     dt = (double)((now - last_dt) / (double)SDL_GetPerformanceFrequency());
 
-    graph_ops_update(SDL_GetTicks64() / 1000.0f, dt);
+    // the canvas is not kept between frames, so every frame is drawn
+    mark_dirty();
+    graph_ops_update(dt);
 
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplSDL2_NewFrame();
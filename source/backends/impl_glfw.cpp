@@ -3,19 +3,22 @@
 
 #include "imgui_impl_glfw.h"
 
+#include "assets.hpp"
 #include "impl_base.hpp"
 #include "io.hpp"
+#include "pack.hpp"
 #include "shader.hpp"
 #include "update.hpp"
 
+// Longest the loop sleeps while nothing changes
+#define IDLE_WAIT_SECONDS 0.5
+
 int width = 1024;
 int height = 768;
 int g_focused = 1;
 
 GLFWwindow *window;
 
-extern GLuint program_id;
-
 static void window_size_callback(GLFWwindow *window, int new_width, int new_height)
 {
     (void)window;
@@ -23,12 +26,45 @@ static void window_size_callback(GLFWwindow *window, int new_width, int new_heig
     height = new_height;
     glViewport(0, 0, width, height);
     projection = glm::perspective(glm::radians(90.0f), (float)width / (float)height, 0.1f, 100.0f);
+    mark_dirty();
 }
 
 static void window_focus_callback(GLFWwindow *window, int focused)
 {
     (void)window;
     g_focused = focused;
+    mark_dirty();
+}
+
+// ImGui chains to these, any input may change what is drawn
+static void cursor_pos_callback(GLFWwindow *, double, double)
+{
+    mark_dirty();
+}
+
+static void mouse_button_callback(GLFWwindow *, int, int, int)
+{
+    mark_dirty();
+}
+
+static void scroll_callback(GLFWwindow *, double, double)
+{
+    mark_dirty();
+}
+
+static void key_callback(GLFWwindow *, int, int, int, int)
+{
+    mark_dirty();
+}
+
+static void char_callback(GLFWwindow *, unsigned int)
+{
+    mark_dirty();
+}
+
+static void window_refresh_callback(GLFWwindow *)
+{
+    mark_dirty();
 }
 
 static void glfw_error_callback(int error, const char *description)
@@ -112,6 +148,12 @@ int main()
 
     glfwSetWindowSizeCallback(window, window_size_callback);
     glfwSetWindowFocusCallback(window, window_focus_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
+    glfwSetCursorPosCallback(window, cursor_pos_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetCharCallback(window, char_callback);
 
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -145,7 +187,13 @@ int main()
 //         }
 // #endif
 
-        graph_ops_update(current_frame, dt);
+        if (!graph_ops_update(dt))
+        {
+            // nothing changed, sleep until input arrives
+            glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+            last_frame = glfwGetTime();
+            continue;
+        }
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -160,6 +208,9 @@ int main()
         glfwPollEvents();
     }
 
+    assets_shutdown();
+    pack_unmount();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -45,155 +45,21 @@ AABB calc_transformed_bounds(AABB const &b, glm::mat4 const &transform)
     return box;
 }
 
-Box::Box(AABB b)
+float projected_size(AABB const &b, glm::mat4 const &view_projection, int width, int height)
 {
-    vertices = {
-        b.min.x,
-        b.min.y,
-        b.min.z,
-        b.max.x,
-        b.min.y,
-        b.min.z,
-        b.max.x,
-        b.max.y,
-        b.min.z,
-        b.min.x,
-        b.max.y,
-        b.min.z,
+    glm::vec2 min = {INFINITY, INFINITY};
+    glm::vec2 max = {-INFINITY, -INFINITY};
 
-        b.min.x,
-        b.min.y,
-        b.max.z,
-        b.max.x,
-        b.min.y,
-        b.max.z,
-        b.max.x,
-        b.max.y,
-        b.max.z,
-        b.min.x,
-        b.max.y,
-        b.max.z,
-
-        b.min.x,
-        b.min.y,
-        b.min.z,
-        b.min.x,
-        b.min.y,
-        b.max.z,
-
-        b.max.x,
-        b.min.y,
-        b.min.z,
-        b.max.x,
-        b.min.y,
-        b.max.z,
-
-        b.max.x,
-        b.max.y,
-        b.min.z,
-        b.max.x,
-        b.max.y,
-        b.max.z,
-
-        b.min.x,
-        b.max.y,
-        b.min.z,
-        b.min.x,
-        b.max.y,
-        b.max.z,
-    };
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
-
-void Box::update(AABB const &b)
-{
-    vertices = {
-        b.min.x,
-        b.min.y,
-        b.min.z,
-        b.max.x,
-        b.min.y,
-        b.min.z,
-        b.max.x,
-        b.max.y,
-        b.min.z,
-        b.min.x,
-        b.max.y,
-        b.min.z,
-
-        b.min.x,
-        b.min.y,
-        b.max.z,
-        b.max.x,
-        b.min.y,
-        b.max.z,
-        b.max.x,
-        b.max.y,
-        b.max.z,
-        b.min.x,
-        b.max.y,
-        b.max.z,
-
-        b.min.x,
-        b.min.y,
-        b.min.z,
-        b.min.x,
-        b.min.y,
-        b.max.z,
-
-        b.max.x,
-        b.min.y,
-        b.min.z,
-        b.max.x,
-        b.min.y,
-        b.max.z,
-
-        b.max.x,
-        b.max.y,
-        b.min.z,
-        b.max.x,
-        b.max.y,
-        b.max.z,
-
-        b.min.x,
-        b.max.y,
-        b.min.z,
-        b.min.x,
-        b.max.y,
-        b.max.z,
-    };
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
-}
-
-void Box::draw()
-{
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_LINE_LOOP, 0, 4);
-    glDrawArrays(GL_LINE_LOOP, 4, 4);
-    glDrawArrays(GL_LINES, 8, 8);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec4 corner = {i & 1 ? b.max.x : b.min.x, i & 2 ? b.max.y : b.min.y, i & 4 ? b.max.z : b.min.z, 1.0f};
+        glm::vec4 clip = view_projection * corner;
+        if (clip.w <= 0.0f)
+            return INFINITY;
+        glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        min = glm::min(min, ndc);
+        max = glm::max(max, ndc);
+    }
 
-Box::~Box()
-{
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    return glm::max((max.x - min.x) * width, (max.y - min.y) * height) * 0.5f;
 }
@@ -0,0 +1,229 @@
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "assets.hpp"
+
+static std::mutex queue_mutex;
+static std::condition_variable queue_ready;
+static std::deque<AssetLoad> loads;
+static std::deque<AssetUpload> uploads;
+static std::vector<std::thread> workers;
+static size_t pending = 0;
+static bool stopping = false;
+
+// Fenced ring of pixel unpack buffers. Without sync objects a buffer is
+// orphaned before reuse instead, leaving the wait to the driver.
+struct StagingBuffer
+{
+    GLuint buffer;
+    size_t capacity;
+    GLsync fence;
+};
+
+static StagingBuffer staging[ASSET_STAGING_BUFFERS];
+static size_t staging_next = 0;
+static bool staging_fences = false;
+
+#ifndef __EMSCRIPTEN__
+static void worker_main()
+{
+    for (;;)
+    {
+        AssetLoad load;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_ready.wait(lock, []
+                             { return stopping || !loads.empty(); });
+            if (stopping)
+                return;
+            load = std::move(loads.front());
+            loads.pop_front();
+        }
+
+        AssetUpload upload = load();
+
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        uploads.push_back(std::move(upload));
+    }
+}
+#endif // __EMSCRIPTEN__
+
+void assets_init()
+{
+#ifdef __EMSCRIPTEN__
+    staging_fences = true;
+#else
+    staging_fences = GLEW_ARB_sync || GLEW_VERSION_3_2;
+#endif // __EMSCRIPTEN__
+
+#ifndef __EMSCRIPTEN__
+    // leave a core for the GL thread
+    unsigned count = std::thread::hardware_concurrency();
+    count = count > 2 ? count - 1 : 1;
+    for (unsigned i = 0; i < count; i++)
+        workers.emplace_back(worker_main);
+#endif // __EMSCRIPTEN__
+}
+
+void assets_shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+        loads.clear();
+    }
+    queue_ready.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+    workers.clear();
+    uploads.clear();
+    pending = 0;
+
+    for (auto &entry : staging)
+    {
+        if (entry.fence)
+            glDeleteSync(entry.fence);
+        if (entry.buffer)
+            glDeleteBuffers(1, &entry.buffer);
+        entry = StagingBuffer{};
+    }
+}
+
+void queue_asset(AssetLoad load)
+{
+    pending++;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        loads.push_back(std::move(load));
+    }
+    queue_ready.notify_one();
+}
+
+int upload_assets(double budget_ms)
+{
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    auto spent = [start]
+    { return std::chrono::duration<double, std::milli>(clock::now() - start).count(); };
+
+#ifdef __EMSCRIPTEN__
+    // no workers on the web, loads share the frame budget with uploads
+    while (!loads.empty() && spent() < budget_ms)
+    {
+        AssetLoad load = std::move(loads.front());
+        loads.pop_front();
+        uploads.push_back(load());
+    }
+#endif // __EMSCRIPTEN__
+
+    int completed = 0;
+    // each upload is looked at once per frame at most, waiting ones go to the back
+    size_t visits;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        visits = uploads.size();
+    }
+    for (; visits > 0 && spent() < budget_ms; visits--)
+    {
+        AssetUpload upload;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (uploads.empty())
+                break;
+            upload = std::move(uploads.front());
+            uploads.pop_front();
+        }
+
+        AssetStep step = ASSET_STEP_MORE;
+        while (step == ASSET_STEP_MORE && spent() < budget_ms)
+            step = upload();
+
+        if (step == ASSET_STEP_DONE)
+        {
+            completed++;
+            pending--;
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (step == ASSET_STEP_MORE)
+            uploads.push_front(std::move(upload)); // out of budget, resume here next frame
+        else
+            uploads.push_back(std::move(upload));
+    }
+    return completed;
+}
+
+size_t assets_pending()
+{
+    return pending;
+}
+
+bool upload_step(BufferUpload &upload)
+{
+    glBindBuffer(upload.target, upload.buffer);
+    if (upload.offset == 0)
+        glBufferData(upload.target, upload.size, NULL, GL_STATIC_DRAW);
+
+    size_t size = upload.size - upload.offset;
+    if (size > ASSET_UPLOAD_CHUNK)
+        size = ASSET_UPLOAD_CHUNK;
+    if (size)
+        glBufferSubData(upload.target, upload.offset, size, (const uint8_t *)upload.data + upload.offset);
+    upload.offset += size;
+    return upload.offset == upload.size;
+}
+
+bool staging_begin(const void *data, size_t size)
+{
+    StagingBuffer &entry = staging[staging_next];
+    if (entry.fence)
+    {
+        GLenum status = glClientWaitSync(entry.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            return false;
+        glDeleteSync(entry.fence);
+        entry.fence = 0;
+    }
+
+    if (!entry.buffer)
+        glGenBuffers(1, &entry.buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, entry.buffer);
+    if (size > entry.capacity || !staging_fences)
+    {
+        if (size > entry.capacity)
+            entry.capacity = size > ASSET_UPLOAD_CHUNK ? size : ASSET_UPLOAD_CHUNK;
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, entry.capacity, NULL, GL_STREAM_DRAW);
+    }
+
+#ifdef __EMSCRIPTEN__
+    // WebGL can't map buffers
+    glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, data);
+#else
+    // the fence already says the GPU is done with it
+    void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!mapped)
+    {
+        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, data);
+        return true;
+    }
+    memcpy(mapped, data, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+#endif // __EMSCRIPTEN__
+    return true;
+}
+
+void staging_end()
+{
+    StagingBuffer &entry = staging[staging_next];
+    if (staging_fences)
+        entry.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    staging_next = (staging_next + 1) % ASSET_STAGING_BUFFERS;
+}
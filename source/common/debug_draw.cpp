@@ -0,0 +1,78 @@
+#include <stddef.h>
+
+#include <vector>
+
+#include "debug_draw.hpp"
+#include "frame_ring.hpp"
+#include "shader.hpp"
+
+static std::vector<DebugVertex> vertices;
+static GLuint vertex_array = 0;
+
+static uint32_t pack_color(glm::vec4 const &color)
+{
+    glm::vec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+    return (uint32_t)c.r | (uint32_t)c.g << 8 | (uint32_t)c.b << 16 | (uint32_t)c.a << 24;
+}
+
+void debug_line(glm::vec3 const &start, glm::vec3 const &end, glm::vec4 const &color)
+{
+    uint32_t packed = pack_color(color);
+    vertices.push_back({start, packed});
+    vertices.push_back({end, packed});
+}
+
+void debug_aabb(AABB const &box, glm::vec4 const &color)
+{
+    uint32_t packed = pack_color(color);
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; i++)
+        corners[i] = {i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z};
+
+    // corners one bit apart share an edge
+    for (int i = 0; i < 8; i++)
+    {
+        for (int bit = 1; bit < 8; bit <<= 1)
+        {
+            if (i & bit)
+                continue;
+            vertices.push_back({corners[i], packed});
+            vertices.push_back({corners[i | bit], packed});
+        }
+    }
+}
+
+void debug_ray(Ray const &ray, float length, glm::vec4 const &color)
+{
+    debug_line(ray.origin, ray.origin + glm::normalize(ray.direction) * length, color);
+}
+
+void debug_flush()
+{
+    if (vertices.empty())
+        return;
+
+    if (!vertex_array)
+    {
+        glGenVertexArrays(1, &vertex_array);
+        glBindVertexArray(vertex_array);
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+    }
+    else
+        glBindVertexArray(vertex_array);
+
+    // the stream moves around the frame ring, so the pointers follow it
+    FrameSpan span = frame_push(vertices.data(), vertices.size() * sizeof(DebugVertex));
+    glBindBuffer(GL_ARRAY_BUFFER, span.buffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void *)(span.offset + offsetof(DebugVertex, position)));
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex), (void *)(span.offset + offsetof(DebugVertex, color)));
+
+    Program *program = request_program("source/shaders/debug.vert.glsl", "source/shaders/debug.frag.glsl");
+    use_program(*program);
+    glDrawArrays(GL_LINES, 0, (GLsizei)vertices.size());
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+    vertices.clear();
+}
@@ -0,0 +1,25 @@
+#include <string.h>
+
+#include "embedded.hpp"
+
+#ifndef EMBED_ASSETS
+const EmbeddedFile embedded_files[1] = {};
+const size_t embedded_file_count = 0;
+#endif // EMBED_ASSETS
+
+EmbeddedFile const *find_embedded(const char *path)
+{
+    size_t lo = 0, hi = embedded_file_count;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        int order = strcmp(embedded_files[mid].path, path);
+        if (order == 0)
+            return &embedded_files[mid];
+        if (order < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return NULL;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "frame_ring.hpp"
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif // GL_MAP_PERSISTENT_BIT
+
+static GLuint ring = 0;
+static size_t capacity = 0; // per frame
+static size_t used = 0;
+static size_t frame = 0; // region in use
+static bool persistent = false;
+static uint8_t *mapped = NULL;
+static GLsync fences[FRAME_RING_FRAMES];
+// the CPU copy without a persistent mapping
+static std::vector<uint8_t> shadow;
+// outgrown rings, spans from earlier in the frame may still point at them
+static std::vector<GLuint> retired;
+
+static void create_ring(size_t size)
+{
+    if (ring)
+        retired.push_back(ring);
+    capacity = size;
+    glGenBuffers(1, &ring);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ring);
+#ifndef __EMSCRIPTEN__
+    if (persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, capacity * FRAME_RING_FRAMES, NULL, flags);
+        mapped = (uint8_t *)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, capacity * FRAME_RING_FRAMES, flags);
+        if (mapped)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            return;
+        }
+        // immutable storage can't be orphaned, start over with a plain buffer
+        printf("Could not map the frame ring, orphaning it instead\n");
+        glDeleteBuffers(1, &ring);
+        glGenBuffers(1, &ring);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ring);
+        persistent = false;
+    }
+#endif // __EMSCRIPTEN__
+    shadow.resize(capacity);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void frame_ring_begin()
+{
+    if (!ring)
+    {
+#ifndef __EMSCRIPTEN__
+        persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+#endif // __EMSCRIPTEN__
+        create_ring(FRAME_RING_SIZE);
+    }
+
+    // the frame before has ended, nothing refers to outgrown rings any more
+    if (!retired.empty())
+    {
+        glDeleteBuffers((GLsizei)retired.size(), retired.data());
+        retired.clear();
+    }
+
+    used = 0;
+    if (!persistent)
+    {
+        // the driver keeps the old storage for draws still in flight
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ring);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return;
+    }
+
+    GLsync &fence = fences[frame];
+    if (fence)
+    {
+        // only waits when the GPU is FRAME_RING_FRAMES frames behind
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+            ;
+        glDeleteSync(fence);
+        fence = 0;
+    }
+}
+
+void frame_ring_end()
+{
+    if (!persistent)
+        return;
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame = (frame + 1) % FRAME_RING_FRAMES;
+}
+
+FrameSpan frame_alloc(size_t size, size_t alignment)
+{
+    size_t offset = (used + alignment - 1) & ~(alignment - 1);
+    if (offset + size > capacity)
+    {
+        // this frame's earlier spans stay in the old ring until the next begin
+        size_t grown = capacity * 2;
+        while (grown < size + alignment)
+            grown *= 2;
+        create_ring(grown);
+        offset = 0;
+    }
+    used = offset + size;
+
+    FrameSpan span;
+    span.buffer = ring;
+    span.size = size;
+    if (persistent)
+    {
+        span.offset = frame * capacity + offset;
+        span.data = mapped + span.offset;
+    }
+    else
+    {
+        span.offset = offset;
+        span.data = shadow.data() + offset;
+    }
+    return span;
+}
+
+void frame_flush(FrameSpan const &span)
+{
+    // coherent, writes are seen by commands issued after them
+    if (persistent)
+        return;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, span.buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, span.offset, span.size, span.data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+FrameSpan frame_push(const void *data, size_t size, size_t alignment)
+{
+    FrameSpan span = frame_alloc(size, alignment);
+    memcpy(span.data, data, size);
+    frame_flush(span);
+    return span;
+}
+
+size_t uniform_alignment()
+{
+    static size_t alignment = 0;
+    if (!alignment)
+    {
+        GLint value = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+        alignment = value > 16 ? (size_t)value : 16;
+    }
+    return alignment;
+}
+
+void frame_uniforms(GLuint binding, const void *data, size_t size)
+{
+    FrameSpan span = frame_push(data, size, uniform_alignment());
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, span.buffer, span.offset, span.size);
+}
@@ -0,0 +1,107 @@
+#include "frustum.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FRUSTUM_SSE2
+#endif
+
+void PackedBounds::clear()
+{
+    min_x.clear();
+    min_y.clear();
+    min_z.clear();
+    max_x.clear();
+    max_y.clear();
+    max_z.clear();
+    count = 0;
+}
+
+void PackedBounds::push(AABB const &box)
+{
+    if (count % 4 == 0)
+    {
+        // padding lanes are tested too, their results are dropped
+        size_t size = count + 4;
+        min_x.resize(size);
+        min_y.resize(size);
+        min_z.resize(size);
+        max_x.resize(size);
+        max_y.resize(size);
+        max_z.resize(size);
+    }
+    min_x[count] = box.min.x;
+    min_y[count] = box.min.y;
+    min_z[count] = box.min.z;
+    max_x[count] = box.max.x;
+    max_y[count] = box.max.y;
+    max_z[count] = box.max.z;
+    count++;
+}
+
+// Gribb and Hartmann, clip space -w <= x, y, z <= w
+Frustum extract_frustum(glm::mat4 const &m)
+{
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+    Frustum frustum;
+    for (int i = 0; i < 3; i++)
+    {
+        frustum.planes[i * 2] = rows[3] + rows[i];
+        frustum.planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+    return frustum;
+}
+
+// A box is outside when its corner furthest along a plane's normal is
+// behind that plane. The corner is picked per plane, so every lane reads
+// the same arrays.
+void cull_frustum(Frustum const &frustum, PackedBounds const &bounds, std::vector<uint32_t> &visible)
+{
+    visible.clear();
+    const float *xs[6], *ys[6], *zs[6];
+    for (int p = 0; p < 6; p++)
+    {
+        glm::vec4 const &plane = frustum.planes[p];
+        xs[p] = plane.x >= 0.0f ? bounds.max_x.data() : bounds.min_x.data();
+        ys[p] = plane.y >= 0.0f ? bounds.max_y.data() : bounds.min_y.data();
+        zs[p] = plane.z >= 0.0f ? bounds.max_z.data() : bounds.min_z.data();
+    }
+
+    for (size_t i = 0; i < bounds.count; i += 4)
+    {
+        int outside = 0;
+#ifdef FRUSTUM_SSE2
+        __m128 zero = _mm_setzero_ps();
+        __m128 out = zero;
+        for (int p = 0; p < 6; p++)
+        {
+            glm::vec4 const &plane = frustum.planes[p];
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), _mm_loadu_ps(xs[p] + i)),
+                                         _mm_mul_ps(_mm_set1_ps(plane.y), _mm_loadu_ps(ys[p] + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), _mm_loadu_ps(zs[p] + i)));
+            distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+            out = _mm_or_ps(out, _mm_cmplt_ps(distance, zero));
+        }
+        outside = _mm_movemask_ps(out);
+#else
+        for (int p = 0; p < 6; p++)
+        {
+            glm::vec4 const &plane = frustum.planes[p];
+            for (int lane = 0; lane < 4; lane++)
+            {
+                float distance = plane.x * xs[p][i + lane] + plane.y * ys[p][i + lane] + plane.z * zs[p][i + lane] + plane.w;
+                if (distance < 0.0f)
+                    outside |= 1 << lane;
+            }
+        }
+#endif // FRUSTUM_SSE2
+
+        for (int lane = 0; lane < 4 && i + lane < bounds.count; lane++)
+        {
+            if (!(outside & (1 << lane)))
+                visible.push_back((uint32_t)(i + lane));
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#include <string>
+
+#include "gom.hpp"
+
+static inline uint64_t align_up(uint64_t offset)
+{
+    return (offset + GOM_ALIGNMENT - 1) & ~(uint64_t)(GOM_ALIGNMENT - 1);
+}
+
+GomLayout gom_layout(uint32_t flags)
+{
+    GomLayout layout;
+    if (flags & GOM_FLAG_QUANTIZED)
+    {
+        layout.position_size = 4 * sizeof(uint16_t);
+        layout.uv_size = 2 * sizeof(uint16_t);
+        layout.normal_size = 2 * sizeof(int16_t);
+    }
+    else
+    {
+        layout.position_size = sizeof(glm::vec3);
+        layout.uv_size = sizeof(glm::vec2);
+        layout.normal_size = sizeof(glm::vec3);
+    }
+    layout.normal_offset = layout.position_size;
+    layout.uv_offset = layout.normal_offset + layout.normal_size;
+    layout.stride = layout.uv_offset + layout.uv_size;
+    return layout;
+}
+
+void gom_interleave(uint32_t flags, size_t vertex_count, const void *positions, const void *normals, const void *uvs, std::vector<uint8_t> &out)
+{
+    GomLayout layout = gom_layout(flags);
+    out.resize(vertex_count * layout.stride);
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+        uint8_t *vertex = out.data() + i * layout.stride;
+        memcpy(vertex, (const uint8_t *)positions + i * layout.position_size, layout.position_size);
+        memcpy(vertex + layout.normal_offset, (const uint8_t *)normals + i * layout.normal_size, layout.normal_size);
+        memcpy(vertex + layout.uv_offset, (const uint8_t *)uvs + i * layout.uv_size, layout.uv_size);
+    }
+}
+
+// FNV-1a over 8 byte words, good enough to notice an edited source
+uint64_t gom_hash(const uint8_t *data, size_t size)
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * 0x100000001B3ull;
+        h ^= h >> 32;
+    }
+    for (; i < size; i++)
+        h = (h ^ data[i]) * 0x100000001B3ull;
+    return h ? h : 1;
+}
+
+bool gom_source_info(const char *source_path, GomSource &source)
+{
+    source.hash = 0;
+    return get_file_info(source_path, &source.size, &source.mtime);
+}
+
+bool gom_source_matches(const char *source_path, GomSource const &source, uint64_t size, int64_t mtime, uint64_t hash)
+{
+    if (size != source.size)
+        return false;
+    if (mtime == source.mtime)
+        return true;
+
+    // touched but maybe not changed, e.g. by a checkout
+    uint64_t current = source.hash;
+    if (!current)
+    {
+        File file = open_or_create_file(source_path, IO_READ_ONLY, 0);
+        if (file.handle == IO_BAD_FILE_HANDLE)
+            return false;
+        if (!map_file(&file))
+        {
+            close_file(file);
+            return false;
+        }
+        current = gom_hash(file.start, file.size);
+        unmap_and_close_file(file);
+    }
+    return current == hash;
+}
+
+bool gom_parse(const uint8_t *data, size_t size, uint32_t flags, GomMesh &mesh)
+{
+    memset(&mesh, 0, sizeof(GomMesh));
+    if (size < sizeof(GomHeader))
+        return false;
+
+    const GomHeader *header = (const GomHeader *)data;
+    GomLayout layout = gom_layout(header->flags);
+    uint64_t vertex_bytes = (uint64_t)header->vertex_count * layout.stride;
+    uint64_t index_bytes = (uint64_t)header->index_count * header->index_size;
+    // offsets are checked first so a corrupt one can't wrap the sum around
+    bool valid = header->magic == GOM_MAGIC && header->version == GOM_VERSION && header->flags == flags &&
+                 (header->index_size == 2 || header->index_size == 4) && header->vertex_stride == layout.stride &&
+                 header->vertices_offset <= size && vertex_bytes <= size - header->vertices_offset &&
+                 header->indices_offset <= size && index_bytes <= size - header->indices_offset &&
+                 header->lod_count >= 1 && header->lod_count <= GOM_MAX_LODS;
+    for (uint32_t i = 0; valid && i < header->lod_count; i++)
+        valid = (uint64_t)header->lods[i].index_offset + header->lods[i].index_count <= header->index_count;
+    if (!valid)
+        return false;
+
+    mesh.header = header;
+    mesh.vertices = data + header->vertices_offset;
+    mesh.indices = data + header->indices_offset;
+    return true;
+}
+
+bool gom_stamp_mtime(const char *path, size_t offset, int64_t mtime)
+{
+    File file = open_or_create_file(path, IO_READ_WRITE, 0);
+    if (file.handle == IO_BAD_FILE_HANDLE)
+        return false;
+    if (file.size < offset + sizeof(mtime) || !map_file(&file))
+    {
+        close_file(file);
+        return false;
+    }
+    memcpy(file.start + offset, &mtime, sizeof(mtime));
+    return unmap_and_close_file(file);
+}
+
+static bool map_cache(const char *path, uint32_t flags, GomMesh &mesh)
+{
+    File file = open_or_create_file(path, IO_READ_ONLY, 0);
+    if (file.handle == IO_BAD_FILE_HANDLE)
+        return false;
+    if (file.size < sizeof(GomHeader) || !map_file(&file))
+    {
+        close_file(file);
+        return false;
+    }
+    if (!gom_parse(file.start, file.size, flags, mesh))
+    {
+        unmap_and_close_file(file);
+        return false;
+    }
+    mesh.file = file;
+    return true;
+}
+
+bool gom_open(const char *path, const char *source_path, GomSource const &source, uint32_t flags, GomMesh &mesh)
+{
+    memset(&mesh, 0, sizeof(GomMesh));
+    if (!file_exists(path) || !map_cache(path, flags, mesh))
+        return false;
+
+    const GomHeader *header = mesh.header;
+    if (!gom_source_matches(source_path, source, header->source_size, header->source_mtime, header->source_hash))
+    {
+        gom_close(mesh);
+        return false;
+    }
+    if (header->source_mtime != source.mtime)
+    {
+        // the source was only touched, Windows won't open the cache a
+        // second time while it is mapped so close it around the stamp
+        gom_close(mesh);
+        gom_stamp_mtime(path, offsetof(GomHeader, source_mtime), source.mtime);
+        return map_cache(path, flags, mesh);
+    }
+    return true;
+}
+
+void gom_close(GomMesh &mesh)
+{
+    // parsed meshes don't own their memory
+    if (mesh.file.start)
+        unmap_and_close_file(mesh.file);
+    memset(&mesh, 0, sizeof(GomMesh));
+}
+
+bool gom_write(const char *path, GomSource const &source, uint32_t flags, GomStreams const &streams,
+               std::vector<uint32_t> const &indices, std::vector<MeshLod> const &lods)
+{
+    if (lods.empty() || lods.size() > GOM_MAX_LODS)
+        return false;
+
+    GomLayout layout = gom_layout(flags);
+    size_t vertex_count = streams.vertex_count;
+
+    GomHeader header;
+    memset(&header, 0, sizeof(GomHeader));
+    header.magic = GOM_MAGIC;
+    header.version = GOM_VERSION;
+    header.source_size = source.size;
+    header.source_mtime = source.mtime;
+    header.source_hash = source.hash;
+    header.vertex_count = streams.vertex_count;
+    header.index_count = (uint32_t)indices.size();
+    header.index_size = vertex_count <= 0x10000 ? 2 : 4;
+    header.flags = flags;
+    header.bounds_min = streams.bounds_min;
+    header.bounds_max = streams.bounds_max;
+    header.position_error = streams.position_error;
+    header.uv_error = streams.uv_error;
+    header.normal_error = streams.normal_error;
+    header.lod_count = (uint32_t)lods.size();
+    memcpy(header.lods, lods.data(), lods.size() * sizeof(MeshLod));
+
+    header.vertex_stride = layout.stride;
+    header.vertices_offset = align_up(sizeof(GomHeader));
+    header.indices_offset = align_up(header.vertices_offset + vertex_count * layout.stride);
+    uint64_t size = header.indices_offset + (uint64_t)indices.size() * header.index_size;
+
+    // write to a temporary and rename so a crash never leaves a torn cache
+    std::string temp_path = std::string(path) + ".tmp";
+    File file = open_or_create_file(temp_path.c_str(), IO_READ_WRITE, 1);
+    if (file.handle == IO_BAD_FILE_HANDLE)
+        return false;
+    if (!truncate_file(&file, size) || !map_file(&file))
+    {
+        close_file(file);
+        remove(temp_path.c_str());
+        return false;
+    }
+
+    memset(file.start, 0, size);
+    memcpy(file.start, &header, sizeof(GomHeader));
+    memcpy(file.start + header.vertices_offset, streams.vertices, vertex_count * layout.stride);
+    if (header.index_size == 2)
+    {
+        uint16_t *out = (uint16_t *)(file.start + header.indices_offset);
+        for (size_t i = 0; i < indices.size(); i++)
+            out[i] = (uint16_t)indices[i];
+    }
+    else
+        memcpy(file.start + header.indices_offset, indices.data(), indices.size() * sizeof(uint32_t));
+
+    if (!unmap_and_close_file(file))
+    {
+        remove(temp_path.c_str());
+        return false;
+    }
+
+    remove(path);
+    return rename(temp_path.c_str(), path) == 0;
+}
@@ -0,0 +1,142 @@
+#include "gtx.hpp"
+
+static inline uint64_t align_up(uint64_t offset)
+{
+    return (offset + GTX_ALIGNMENT - 1) & ~(uint64_t)(GTX_ALIGNMENT - 1);
+}
+
+std::string gtx_cache_path(const char *source_path, TextureFormat format)
+{
+    static const char *suffixes[] = {".rgb8.gtx", ".bc1.gtx", ".etc2.gtx"};
+    return std::string(source_path) + suffixes[format];
+}
+
+bool gtx_parse(const uint8_t *data, size_t size, TextureFormat format, GtxTexture &texture)
+{
+    memset(&texture, 0, sizeof(GtxTexture));
+    if (size < sizeof(GtxHeader))
+        return false;
+
+    const GtxHeader *header = (const GtxHeader *)data;
+    bool valid = header->magic == GTX_MAGIC && header->version == GTX_VERSION && header->format == format &&
+                 header->level_count >= 1 && header->level_count <= GTX_MAX_LEVELS;
+    for (uint32_t i = 0; valid && i < header->level_count; i++)
+    {
+        const GtxLevel &level = header->levels[i];
+        valid = level.size == texture_level_size(format, level.width, level.height) &&
+                level.offset <= size && level.size <= size - level.offset;
+    }
+    if (!valid)
+        return false;
+
+    texture.header = header;
+    texture.data = data;
+    return true;
+}
+
+static bool map_cache(const char *path, TextureFormat format, GtxTexture &texture)
+{
+    File file = open_or_create_file(path, IO_READ_ONLY, 0);
+    if (file.handle == IO_BAD_FILE_HANDLE)
+        return false;
+    if (file.size < sizeof(GtxHeader) || !map_file(&file))
+    {
+        close_file(file);
+        return false;
+    }
+    if (!gtx_parse(file.start, file.size, format, texture))
+    {
+        unmap_and_close_file(file);
+        return false;
+    }
+    texture.file = file;
+    return true;
+}
+
+bool gtx_open(const char *path, const char *source_path, GomSource const &source, TextureFormat format, GtxTexture &texture)
+{
+    memset(&texture, 0, sizeof(GtxTexture));
+    if (!file_exists(path) || !map_cache(path, format, texture))
+        return false;
+
+    const GtxHeader *header = texture.header;
+    if (!gom_source_matches(source_path, source, header->source_size, header->source_mtime, header->source_hash))
+    {
+        gtx_close(texture);
+        return false;
+    }
+    if (header->source_mtime != source.mtime)
+    {
+        // touched but unchanged, see gom_open
+        gtx_close(texture);
+        gom_stamp_mtime(path, offsetof(GtxHeader, source_mtime), source.mtime);
+        return map_cache(path, format, texture);
+    }
+    return true;
+}
+
+void gtx_close(GtxTexture &texture)
+{
+    // parsed textures don't own their memory
+    if (texture.file.start)
+        unmap_and_close_file(texture.file);
+    memset(&texture, 0, sizeof(GtxTexture));
+}
+
+const uint8_t *gtx_level_data(GtxTexture const &texture, uint32_t level)
+{
+    return texture.data + texture.header->levels[level].offset;
+}
+
+bool gtx_write(const char *path, GomSource const &source, TextureFormat format, std::vector<TextureLevel> const &levels)
+{
+    if (levels.empty() || levels.size() > GTX_MAX_LEVELS)
+        return false;
+
+    GtxHeader header;
+    memset(&header, 0, sizeof(GtxHeader));
+    header.magic = GTX_MAGIC;
+    header.version = GTX_VERSION;
+    header.source_size = source.size;
+    header.source_mtime = source.mtime;
+    header.source_hash = source.hash;
+    header.format = format;
+    header.level_count = (uint32_t)levels.size();
+
+    uint64_t size = align_up(sizeof(GtxHeader));
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        GtxLevel &level = header.levels[i];
+        level.width = levels[i].width;
+        level.height = levels[i].height;
+        level.offset = size;
+        level.size = texture_level_size(format, level.width, level.height);
+        size = align_up(size + level.size);
+    }
+
+    // write to a temporary and rename so a crash never leaves a torn cache
+    std::string temp_path = std::string(path) + ".tmp";
+    File file = open_or_create_file(temp_path.c_str(), IO_READ_WRITE, 1);
+    if (file.handle == IO_BAD_FILE_HANDLE)
+        return false;
+    if (!truncate_file(&file, size) || !map_file(&file))
+    {
+        close_file(file);
+        remove(temp_path.c_str());
+        return false;
+    }
+
+    memset(file.start, 0, size);
+    memcpy(file.start, &header, sizeof(GtxHeader));
+    for (size_t i = 0; i < levels.size(); i++)
+        encode_texture(format, levels[i].pixels.data(), levels[i].width, levels[i].height, file.start + header.levels[i].offset);
+
+    if (!unmap_and_close_file(file))
+    {
+        remove(temp_path.c_str());
+        return false;
+    }
+
+    remove(path);
+    return rename(temp_path.c_str(), path) == 0;
+}
@@ -0,0 +1,19 @@
+#include "instancing.hpp"
+
+void bind_instances(GLuint buffer, size_t offset)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (int column = 0; column < 4; column++)
+    {
+        GLuint location = 3 + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void *)(offset + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+    glEnableVertexAttribArray(7);
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void *)(offset + offsetof(InstanceData, color)));
+    glVertexAttribDivisor(7, 1);
+    glEnableVertexAttribArray(8);
+    glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void *)(offset + offsetof(InstanceData, layer)));
+    glVertexAttribDivisor(8, 1);
+}
@@ -139,6 +139,24 @@ int file_exists(const char *path)
 #endif // _WIN32
 }
 
+int create_directory(const char *path)
+{
+#ifdef _WIN32
+    if (!CreateDirectoryA(path, 0) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        error("CreateDirectoryA failed (%ld)", GetLastError());
+        return 0;
+    }
+#else
+    if (mkdir(path, 0700) < 0 && errno != EEXIST)
+    {
+        error("mkdir failed (%s: %s)", path, strerror(errno));
+        return 0;
+    }
+#endif // _WIN32
+    return 1;
+}
+
 int truncate_file(File *f, size_t new_size)
 {
 #ifdef _WIN32
@@ -185,6 +203,35 @@ int get_file_size(File *f)
     return 1;
 }
 
+// mtime is in platform ticks and only meant to be compared for equality
+int get_file_info(const char *path, uint64_t *size, int64_t *mtime)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data))
+    {
+        error("GetFileAttributesExA failed (%ld)", GetLastError());
+        return 0;
+    }
+    *size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    *mtime = (int64_t)(((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime);
+#else
+    struct stat statbuf;
+    if (stat(path, &statbuf) < 0)
+    {
+        error("stat failed (%s: %s)", path, strerror(errno));
+        return 0;
+    }
+    *size = statbuf.st_size;
+#ifdef __APPLE__
+    *mtime = (int64_t)statbuf.st_mtimespec.tv_sec * 1000000000 + statbuf.st_mtimespec.tv_nsec;
+#else
+    *mtime = (int64_t)statbuf.st_mtim.tv_sec * 1000000000 + statbuf.st_mtim.tv_nsec;
+#endif // __APPLE__
+#endif // _WIN32
+    return 1;
+}
+
 int map_file(File *f)
 {
 #ifdef _WIN32
@@ -1,58 +0,0 @@
-#include "line.hpp"
-
-Line::Line(glm::vec3 start, glm::vec3 end)
-{
-    vertices = {
-        start.x,
-        start.y,
-        start.z,
-        end.x,
-        end.y,
-        end.z,
-    };
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, 24, vertices.data(), GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
-
-void Line::update(glm::vec3 const &start, glm::vec3 const &end)
-{
-    vertices = {
-        start.x,
-        start.y,
-        start.z,
-        end.x,
-        end.y,
-        end.z,
-    };
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, 24, vertices.data());
-}
-
-void Line::draw()
-{
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_LINES, 0, 2);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
-
-Line::~Line()
-{
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-}
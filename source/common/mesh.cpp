@@ -0,0 +1,243 @@
+#include <math.h>
+
+#include <unordered_map>
+
+#include "assets.hpp"
+#include "mesh.hpp"
+
+static std::unordered_map<std::string, std::weak_ptr<Mesh>> registry;
+static uint32_t mesh_count = 0;
+
+static GLuint create_buffer(GLenum target, size_t size, const void *data)
+{
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferData(target, size, data, GL_STATIC_DRAW);
+    return buffer;
+}
+
+Mesh::Mesh()
+    : id(mesh_count++), loaded(false)
+{
+    MeshData data;
+    for (int i = 0; i < 8; i++)
+        data.vertices.push_back(glm::vec3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f));
+    data.uvs.resize(8, glm::vec2(0.0f));
+    data.normals.resize(8, glm::vec3(0.0f));
+    data.indices = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6,
+                    0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7,
+                    0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+    data.lods = {MeshLod{0, (uint32_t)data.indices.size(), 0.0f}};
+    fill_streams(data);
+
+    assign(data);
+    vertex_buffer = create_buffer(GL_ARRAY_BUFFER, data.interleaved.size(), data.streams.vertices);
+    element_buffer = create_buffer(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * data.index_size, data.index_data);
+    build_vertex_array();
+}
+
+Mesh::Mesh(MeshData const &data)
+    : id(mesh_count++)
+{
+    assign(data);
+    size_t vertex_count = data.streams.vertex_count;
+    vertex_buffer = create_buffer(GL_ARRAY_BUFFER, vertex_count * gom_layout(flags).stride, data.streams.vertices);
+    element_buffer = create_buffer(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * data.index_size, data.index_data);
+    build_vertex_array();
+}
+
+// Keeps a float copy of whatever format the streams are in
+void Mesh::assign(MeshData const &data)
+{
+    const GomStreams &streams = data.streams;
+    size_t count = streams.vertex_count;
+    GomLayout layout = gom_layout(data.flags);
+    const uint8_t *interleaved = (const uint8_t *)streams.vertices;
+    flags = data.flags;
+    indices = data.indices;
+    lods = data.lods;
+    index_type = data.index_size == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    bounds.min = streams.bounds_min;
+    bounds.max = streams.bounds_max;
+
+    if (flags & MESH_QUANTIZE)
+    {
+        std::vector<glm::u16vec4> positions(count);
+        std::vector<uint32_t> packed_uvs(count), packed_normals(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint8_t *vertex = interleaved + i * layout.stride;
+            memcpy(&positions[i], vertex, sizeof(glm::u16vec4));
+            memcpy(&packed_normals[i], vertex + layout.normal_offset, sizeof(uint32_t));
+            memcpy(&packed_uvs[i], vertex + layout.uv_offset, sizeof(uint32_t));
+        }
+        dequantize_streams(count, positions.data(), packed_uvs.data(), packed_normals.data(), bounds.min, bounds.max, vertices, uvs, normals);
+        dequantize = dequantize_matrix(bounds.min, bounds.max);
+    }
+    else
+    {
+        vertices.resize(count);
+        uvs.resize(count);
+        normals.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint8_t *vertex = interleaved + i * layout.stride;
+            memcpy(&vertices[i], vertex, sizeof(glm::vec3));
+            memcpy(&normals[i], vertex + layout.normal_offset, sizeof(glm::vec3));
+            memcpy(&uvs[i], vertex + layout.uv_offset, sizeof(glm::vec2));
+        }
+        dequantize = glm::mat4(1.0f);
+    }
+}
+
+void Mesh::build_vertex_array()
+{
+    GomLayout layout = gom_layout(flags);
+    bool quantized = flags & MESH_QUANTIZE;
+
+    if (!vertex_array)
+        glGenVertexArrays(1, &vertex_array);
+    glBindVertexArray(vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+
+    glEnableVertexAttribArray(0);
+    if (quantized)
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, layout.stride, (void *)0);
+    else
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, layout.stride, (void *)0);
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, quantized ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, layout.stride, (void *)(uintptr_t)layout.uv_offset);
+
+    // octahedral when quantized, the shader has to unpack it
+    glEnableVertexAttribArray(2);
+    if (quantized)
+        glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, layout.stride, (void *)(uintptr_t)layout.normal_offset);
+    else
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, layout.stride, (void *)(uintptr_t)layout.normal_offset);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
+    glBindVertexArray(0);
+}
+
+void Mesh::replace(GLuint new_vertex_buffer, GLuint new_element_buffer, MeshData const &data)
+{
+    glDeleteBuffers(1, &vertex_buffer);
+    glDeleteBuffers(1, &element_buffer);
+    vertex_buffer = new_vertex_buffer;
+    element_buffer = new_element_buffer;
+    assign(data);
+    build_vertex_array();
+    loaded = true;
+}
+
+Mesh::~Mesh()
+{
+    // a load of the same key after the last reference is gone starts over
+    if (!key.empty())
+    {
+        auto it = registry.find(key);
+        if (it != registry.end() && it->second.expired())
+            registry.erase(it);
+    }
+    glDeleteBuffers(1, &vertex_buffer);
+    glDeleteBuffers(1, &element_buffer);
+    glDeleteVertexArrays(1, &vertex_array);
+}
+
+MeshLod const &Mesh::select_lod(float screen_size) const
+{
+    size_t lod = lods.size() - 1;
+    while (lod > 0 && lods[lod].error * screen_size > MESH_LOD_PIXEL_ERROR)
+        lod--;
+    return lods[lod];
+}
+
+// The same file loaded with other flags has another layout
+static std::string registry_key(const char *path, uint32_t flags)
+{
+    return std::string(path) + '#' + std::to_string(flags);
+}
+
+std::shared_ptr<Mesh> load_mesh(const char *path, uint32_t flags)
+{
+    std::string key = registry_key(path, flags);
+    auto &entry = registry[key];
+    if (auto mesh = entry.lock())
+        return mesh;
+
+    // an unreadable file keeps the placeholder cube
+    MeshData data;
+    auto mesh = read_mesh_data(path, flags, data) ? std::make_shared<Mesh>(data) : std::make_shared<Mesh>();
+    mesh->path = path;
+    mesh->key = key;
+    entry = mesh;
+    return mesh;
+}
+
+// Vertex and index buffers filled a chunk per step, swapped in at the end
+struct MeshUpload
+{
+    std::weak_ptr<Mesh> mesh;
+    std::unique_ptr<MeshData> data;
+    bool valid = false; // read_mesh_data succeeded
+    BufferUpload buffers[2] = {};
+    size_t current = 0;
+
+    AssetStep step()
+    {
+        // read_mesh_data logged why, the placeholder cube stays
+        if (!valid)
+            return ASSET_STEP_DONE;
+        if (mesh.expired())
+        {
+            // nobody is left to draw it
+            if (buffers[0].buffer)
+                glDeleteBuffers(1, &buffers[0].buffer);
+            if (buffers[1].buffer)
+                glDeleteBuffers(1, &buffers[1].buffer);
+            return ASSET_STEP_DONE;
+        }
+
+        if (!buffers[0].buffer)
+        {
+            size_t vertex_count = data->streams.vertex_count;
+            buffers[0] = BufferUpload{GL_ARRAY_BUFFER, 0, data->streams.vertices, vertex_count * gom_layout(data->flags).stride, 0};
+            buffers[1] = BufferUpload{GL_ELEMENT_ARRAY_BUFFER, 0, data->index_data, data->indices.size() * data->index_size, 0};
+            glGenBuffers(1, &buffers[0].buffer);
+            glGenBuffers(1, &buffers[1].buffer);
+        }
+
+        if (upload_step(buffers[current]) && ++current == 2)
+        {
+            mesh.lock()->replace(buffers[0].buffer, buffers[1].buffer, *data);
+            return ASSET_STEP_DONE;
+        }
+        return ASSET_STEP_MORE;
+    }
+};
+
+std::shared_ptr<Mesh> load_mesh_async(const char *path, uint32_t flags)
+{
+    std::string key = registry_key(path, flags);
+    auto &entry = registry[key];
+    if (auto mesh = entry.lock())
+        return mesh;
+
+    auto mesh = std::make_shared<Mesh>();
+    mesh->path = path;
+    mesh->key = key;
+    entry = mesh;
+
+    std::weak_ptr<Mesh> weak = mesh;
+    std::string source = path;
+    queue_asset([weak, source, flags]() -> AssetUpload
+                {
+                    auto upload = std::make_shared<MeshUpload>();
+                    upload->mesh = weak;
+                    upload->data.reset(new MeshData());
+                    upload->valid = read_mesh_data(source.c_str(), flags, *upload->data);
+                    return [upload]() { return upload->step(); }; });
+    return mesh;
+}
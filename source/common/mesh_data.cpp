@@ -0,0 +1,165 @@
+#include <math.h>
+
+#include <string>
+
+#include "mesh_data.hpp"
+#include "obj.hpp"
+#include "pack.hpp"
+
+MeshData::~MeshData()
+{
+    gom_close(cached);
+}
+
+static void compute_bounds(std::vector<glm::vec3> const &vertices, glm::vec3 &min, glm::vec3 &max)
+{
+    min = glm::vec3(INFINITY);
+    max = glm::vec3(-INFINITY);
+    for (const auto &vertex : vertices)
+    {
+        min = glm::min(min, vertex);
+        max = glm::max(max, vertex);
+    }
+}
+
+void fill_streams(MeshData &data)
+{
+    GomStreams &streams = data.streams;
+    streams = {};
+    streams.vertex_count = (uint32_t)data.vertices.size();
+    compute_bounds(data.vertices, streams.bounds_min, streams.bounds_max);
+
+    if (data.flags & MESH_QUANTIZE)
+    {
+        QuantizedStreams &quantized = data.quantized;
+        quantize_streams(data.vertices, data.uvs, data.normals, streams.bounds_min, streams.bounds_max, quantized);
+        gom_interleave(data.flags, streams.vertex_count, quantized.positions.data(), quantized.normals.data(), quantized.uvs.data(), data.interleaved);
+        streams.position_error = quantized.position_error;
+        streams.uv_error = quantized.uv_error;
+        streams.normal_error = quantized.normal_error;
+    }
+    else
+        gom_interleave(data.flags, streams.vertex_count, data.vertices.data(), data.normals.data(), data.uvs.data(), data.interleaved);
+    streams.vertices = data.interleaved.data();
+
+    if (streams.vertex_count <= 0x10000)
+    {
+        data.short_indices.assign(data.indices.begin(), data.indices.end());
+        data.index_data = data.short_indices.data();
+        data.index_size = sizeof(uint16_t);
+    }
+    else
+    {
+        data.index_data = data.indices.data();
+        data.index_size = sizeof(uint32_t);
+    }
+}
+
+// Copies the cache's indices for picking, false when one points past its vertices
+static bool copy_cached_indices(GomMesh const &cached, std::vector<uint32_t> &indices)
+{
+    const GomHeader *header = cached.header;
+    const uint16_t *shorts = (const uint16_t *)cached.indices;
+    const uint32_t *longs = (const uint32_t *)cached.indices;
+    indices.resize(header->index_count);
+    for (uint32_t i = 0; i < header->index_count; i++)
+    {
+        uint32_t index = header->index_size == 2 ? shorts[i] : longs[i];
+        if (index >= header->vertex_count)
+            return false;
+        indices[i] = index;
+    }
+    return true;
+}
+
+bool read_mesh_data(const char *path, uint32_t flags, MeshData &data)
+{
+    std::string cache_path = std::string(path) + ".gom";
+    GomSource source = {};
+    bool have_source = false;
+    data.flags = flags;
+
+    // packed and embedded caches come from the build, their source isn't checked
+    GomMesh &cached = data.cached;
+    AssetSpan packed;
+    bool have_cache = find_packed(cache_path.c_str(), packed) && gom_parse(packed.data, packed.size, flags, cached);
+    if (!have_cache)
+    {
+        have_source = gom_source_info(path, source);
+        have_cache = have_source && gom_open(cache_path.c_str(), path, source, flags, cached);
+    }
+    if (have_cache && !copy_cached_indices(cached, data.indices))
+    {
+        printf("Invalid mesh cache %s, rebuilding it\n", cache_path.c_str());
+        gom_close(cached);
+        have_cache = false;
+        if (!have_source)
+            have_source = gom_source_info(path, source);
+    }
+
+    if (have_cache)
+    {
+        // uploads straight from the mapping, nothing is parsed
+        const GomHeader *header = cached.header;
+        printf("Loading mesh cache %s...\n", cache_path.c_str());
+        if (flags & MESH_QUANTIZE)
+            printf("Quantized %s: position error %g, uv error %g, normal error %.3f degrees\n",
+                   path, header->position_error, header->uv_error, header->normal_error);
+
+        GomStreams &streams = data.streams;
+        streams.vertex_count = header->vertex_count;
+        streams.vertices = cached.vertices;
+        streams.bounds_min = header->bounds_min;
+        streams.bounds_max = header->bounds_max;
+
+        data.index_data = cached.indices;
+        data.index_size = header->index_size;
+        data.lods.assign(header->lods, header->lods + header->lod_count);
+        return true;
+    }
+
+    printf("Loading OBJ file %s...\n", path);
+
+    ObjData obj;
+    if (!load_obj(path, obj, &source.hash))
+    {
+        printf("File can't be read by our simple parser :-( Try exporting with other options\n");
+        return false;
+    }
+
+    std::vector<uint32_t> &indices = data.indices;
+    weld_obj(obj, data.vertices, data.uvs, data.normals, indices);
+    printf("Welded %zu corners into %zu vertices\n", indices.size(), data.vertices.size());
+
+    // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
+    for (auto &uv : data.uvs)
+        uv.y = -uv.y;
+
+    if (flags & MESH_OPTIMIZE)
+    {
+        VertexCacheStats before = analyze_vertex_cache(indices, data.vertices.size());
+        optimize_vertex_cache(indices, data.vertices.size());
+        optimize_vertex_fetch(indices, data.vertices, data.uvs, data.normals);
+        VertexCacheStats after = analyze_vertex_cache(indices, data.vertices.size());
+        printf("Optimized %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", path, before.acmr, after.acmr, before.atvr, after.atvr);
+    }
+
+    data.lods = {MeshLod{0, (uint32_t)indices.size(), 0.0f}};
+    if (flags & MESH_LODS)
+    {
+        build_lods(indices, data.vertices, data.lods);
+        printf("Simplified %s: %zu levels,", path, data.lods.size());
+        for (const auto &lod : data.lods)
+            printf(" %u", lod.index_count / 3);
+        printf(" triangles, error %g\n", data.lods.back().error);
+    }
+
+    fill_streams(data);
+    if (flags & MESH_QUANTIZE)
+        printf("Quantized %s: position error %g, uv error %g, normal error %.3f degrees\n",
+               path, data.quantized.position_error, data.quantized.uv_error, data.quantized.normal_error);
+
+    if (have_source && !gom_write(cache_path.c_str(), source, flags, data.streams, indices, data.lods))
+        printf("Could not write mesh cache %s\n", cache_path.c_str());
+    return true;
+}
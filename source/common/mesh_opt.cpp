@@ -0,0 +1,667 @@
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "mesh_opt.hpp"
+
+VertexCacheStats analyze_vertex_cache(std::vector<uint32_t> const &indices, size_t vertex_count, unsigned cache_size)
+{
+    // a vertex is still cached if fewer than cache_size misses happened since it was loaded
+    std::vector<uint32_t> loaded_at(vertex_count, 0);
+    uint32_t misses = 0;
+    uint32_t clock = cache_size + 1;
+
+    for (auto index : indices)
+    {
+        if (clock - loaded_at[index] > cache_size)
+        {
+            loaded_at[index] = clock++;
+            misses++;
+        }
+    }
+
+    VertexCacheStats stats;
+    stats.acmr = indices.empty() ? 0.0f : (float)misses / (indices.size() / 3);
+    stats.atvr = vertex_count ? (float)misses / vertex_count : 0.0f;
+    return stats;
+}
+
+// Scoring constants from Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+#define FORSYTH_CACHE_SIZE 32
+
+static float vertex_score(int cache_position, uint32_t remaining)
+{
+    if (remaining == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cache_position >= 0)
+    {
+        // the last triangle's vertices score the same so it isn't favoured
+        if (cache_position < 3)
+            score = 0.75f;
+        else
+            score = powf(1.0f - (cache_position - 3) / (float)(FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+
+    // favour vertices with few triangles left so they leave the cache for good
+    return score + 2.0f / sqrtf((float)remaining);
+}
+
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count)
+{
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+        return;
+
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for (auto index : indices)
+        remaining[index]++;
+
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> score(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++)
+        score[v] = vertex_score(-1, remaining[v]);
+
+    std::vector<float> triangle_score(triangle_count);
+    std::vector<char> emitted(triangle_count, 0);
+    size_t best = 0;
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        triangle_score[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+        if (triangle_score[t] > triangle_score[best])
+            best = t;
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t next_cache[FORSYTH_CACHE_SIZE + 3];
+    size_t cache_count = 0;
+    size_t scan = 0;
+
+    for (size_t emitted_count = 0; emitted_count < triangle_count; emitted_count++)
+    {
+        const uint32_t *tri = &indices[best * 3];
+        result.insert(result.end(), tri, tri + 3);
+        emitted[best] = 1;
+
+        // drop the triangle from its vertices' adjacency lists
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t v = tri[k];
+            uint32_t *list = &adjacency[offsets[v]];
+            for (uint32_t i = 0; i < remaining[v]; i++)
+            {
+                if (list[i] == best)
+                {
+                    list[i] = list[remaining[v] - 1];
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+
+        // the triangle's vertices move to the front of the cache
+        size_t next_count = 0;
+        for (int k = 0; k < 3; k++)
+            next_cache[next_count++] = tri[k];
+        for (size_t i = 0; i < cache_count; i++)
+        {
+            uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                next_cache[next_count++] = v;
+        }
+
+        for (size_t i = 0; i < next_count; i++)
+        {
+            uint32_t v = next_cache[i];
+            cache_position[v] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+            score[v] = vertex_score(cache_position[v], remaining[v]);
+        }
+
+        cache_count = next_count < FORSYTH_CACHE_SIZE ? next_count : FORSYTH_CACHE_SIZE;
+        memcpy(cache, next_cache, cache_count * sizeof(uint32_t));
+
+        // only triangles touching the cache changed score
+        float best_score = -1.0f;
+        for (size_t i = 0; i < next_count; i++)
+        {
+            uint32_t v = next_cache[i];
+            for (uint32_t j = 0; j < remaining[v]; j++)
+            {
+                uint32_t t = adjacency[offsets[v] + j];
+                const uint32_t *other = &indices[t * 3];
+                triangle_score[t] = score[other[0]] + score[other[1]] + score[other[2]];
+                if (triangle_score[t] > best_score)
+                {
+                    best_score = triangle_score[t];
+                    best = t;
+                }
+            }
+        }
+
+        // nothing left around the cache, continue with the next unused triangle
+        if (best_score < 0.0f)
+        {
+            while (scan < triangle_count && emitted[scan])
+                scan++;
+            best = scan;
+        }
+    }
+
+    indices.swap(result);
+}
+
+template <typename T>
+static void remap_stream(std::vector<T> &stream, std::vector<uint32_t> const &remap, size_t count)
+{
+    if (stream.empty())
+        return;
+    std::vector<T> result(count);
+    for (size_t i = 0; i < remap.size(); i++)
+        if (remap[i] != UINT32_MAX)
+            result[remap[i]] = stream[i];
+    stream.swap(result);
+}
+
+void optimize_vertex_fetch(std::vector<uint32_t> &indices, std::vector<glm::vec3> &vertices, std::vector<glm::vec2> &uvs, std::vector<glm::vec3> &normals)
+{
+    std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+    uint32_t next = 0;
+
+    for (auto &index : indices)
+    {
+        if (remap[index] == UINT32_MAX)
+            remap[index] = next++;
+        index = remap[index];
+    }
+
+    remap_stream(vertices, remap, next);
+    remap_stream(uvs, remap, next);
+    remap_stream(normals, remap, next);
+}
+
+// Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics".
+// Quadrics are area weighted so the error reads as a squared distance.
+struct Quadric
+{
+    double a00, a11, a22, a01, a02, a12;
+    double b0, b1, b2;
+    double c;
+    double w;
+};
+
+static Quadric plane_quadric(glm::vec3 const &p0, glm::vec3 const &p1, glm::vec3 const &p2)
+{
+    Quadric q = {};
+    glm::dvec3 n = glm::cross(glm::dvec3(p1 - p0), glm::dvec3(p2 - p0));
+    double length = glm::length(n);
+    if (length == 0.0)
+        return q;
+
+    n /= length;
+    double d = -glm::dot(n, glm::dvec3(p0));
+    double w = length * 0.5;
+    q.a00 = w * n.x * n.x;
+    q.a11 = w * n.y * n.y;
+    q.a22 = w * n.z * n.z;
+    q.a01 = w * n.x * n.y;
+    q.a02 = w * n.x * n.z;
+    q.a12 = w * n.y * n.z;
+    q.b0 = w * n.x * d;
+    q.b1 = w * n.y * d;
+    q.b2 = w * n.z * d;
+    q.c = w * d * d;
+    q.w = w;
+    return q;
+}
+
+static void quadric_add(Quadric &q, Quadric const &r)
+{
+    q.a00 += r.a00;
+    q.a11 += r.a11;
+    q.a22 += r.a22;
+    q.a01 += r.a01;
+    q.a02 += r.a02;
+    q.a12 += r.a12;
+    q.b0 += r.b0;
+    q.b1 += r.b1;
+    q.b2 += r.b2;
+    q.c += r.c;
+    q.w += r.w;
+}
+
+static float quadric_error(Quadric const &q, glm::vec3 const &v)
+{
+    double x = v.x, y = v.y, z = v.z;
+    double r = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+               2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+               2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+    return q.w > 0.0 ? (float)(fabs(r) / q.w) : 0.0f;
+}
+
+struct Collapse
+{
+    uint32_t from;
+    uint32_t to;
+    // the other side of a uv seam moves along with it
+    uint32_t seam_from;
+    uint32_t seam_to;
+    float error;
+};
+
+struct PositionHash
+{
+    size_t operator()(glm::vec3 const &v) const
+    {
+        uint32_t bits[3];
+        memcpy(bits, &v, sizeof(bits));
+        return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+    }
+};
+
+static inline uint64_t edge_key(uint32_t a, uint32_t b)
+{
+    return ((uint64_t)a << 32) | b;
+}
+
+enum VertexKind : uint8_t
+{
+    VERTEX_LOCKED,   // open border, corner or non-manifold, never moves
+    VERTEX_MANIFOLD, // one wedge, every edge shared by two triangles
+    VERTEX_SEAM,     // one of two wedges along a uv or normal seam
+};
+
+// Welded vertices at the same position are wedges of one surface point
+struct Wedges
+{
+    std::vector<uint32_t> position; // first wedge at the same position
+    std::vector<uint32_t> count;
+    std::vector<uint32_t> partner; // the other wedge when count is 2
+};
+
+// Manifoldness is judged on positions, seams are edges open in the index
+// topology whose ends both have a wedge on the other side
+static void classify_vertices(std::vector<uint32_t> const &indices, Wedges const &wedges, std::vector<VertexKind> &kind,
+                              std::vector<uint32_t> &open_next, std::vector<uint32_t> &open_prev)
+{
+    size_t vertex_count = kind.size();
+    std::unordered_map<uint64_t, uint32_t> edges, position_edges;
+    edges.reserve(indices.size());
+    position_edges.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+            edges[edge_key(a, b)]++;
+            position_edges[edge_key(wedges.position[a], wedges.position[b])]++;
+        }
+    }
+
+    std::vector<uint8_t> open_out(vertex_count, 0), open_in(vertex_count, 0), bad(vertex_count, 0);
+    open_next.assign(vertex_count, UINT32_MAX);
+    open_prev.assign(vertex_count, UINT32_MAX);
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+            uint32_t pa = wedges.position[a], pb = wedges.position[b];
+            auto opposite = position_edges.find(edge_key(pb, pa));
+            if (position_edges[edge_key(pa, pb)] != 1 || opposite == position_edges.end() || opposite->second != 1)
+                bad[a] = bad[b] = 1;
+            if (edges.find(edge_key(b, a)) == edges.end())
+            {
+                open_out[a]++;
+                open_next[a] = b;
+                open_in[b]++;
+                open_prev[b] = a;
+            }
+        }
+    }
+
+    for (size_t v = 0; v < vertex_count; v++)
+    {
+        if (bad[v])
+            kind[v] = VERTEX_LOCKED;
+        else if (wedges.count[v] == 1)
+            kind[v] = VERTEX_MANIFOLD;
+        else if (wedges.count[v] == 2 && open_out[v] == 1 && open_in[v] == 1)
+            kind[v] = VERTEX_SEAM;
+        else
+            kind[v] = VERTEX_LOCKED;
+    }
+    for (size_t v = 0; v < vertex_count; v++)
+        if (kind[v] == VERTEX_SEAM && kind[wedges.partner[v]] != VERTEX_SEAM)
+            kind[v] = VERTEX_LOCKED;
+}
+
+// Moving from onto to must not turn any remaining triangle around, nor mix
+// wedges of to, which would drag the wrong uvs along
+static bool collapse_valid(std::vector<uint32_t> const &indices, std::vector<glm::vec3> const &vertices, Wedges const &wedges,
+                           std::vector<uint32_t> const &offsets, std::vector<uint32_t> const &adjacency, uint32_t from, uint32_t to)
+{
+    for (uint32_t i = offsets[from]; i < offsets[from + 1]; i++)
+    {
+        const uint32_t *tri = &indices[adjacency[i] * 3];
+        bool shared = false;
+        for (int k = 0; k < 3; k++)
+        {
+            if (tri[k] == to)
+                shared = true;
+            else if (wedges.position[tri[k]] == wedges.position[to])
+                return false;
+        }
+        if (shared)
+            continue;
+
+        glm::vec3 p[3], q[3];
+        for (int k = 0; k < 3; k++)
+        {
+            p[k] = vertices[tri[k]];
+            q[k] = tri[k] == from ? vertices[to] : p[k];
+        }
+        glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+        glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+        if (glm::dot(before, after) <= 0.0f)
+            return false;
+    }
+    return true;
+}
+
+// One round of non-overlapping collapses, cheapest first. Returns how many were made.
+static size_t collapse_pass(std::vector<uint32_t> &indices, std::vector<glm::vec3> const &vertices, Wedges const &wedges,
+                            std::vector<Quadric> &quadrics, size_t target_index_count, float max_error, float &error)
+{
+    size_t vertex_count = vertices.size();
+    std::vector<VertexKind> kind(vertex_count);
+    std::vector<uint32_t> open_next, open_prev;
+    classify_vertices(indices, wedges, kind, open_next, open_prev);
+
+    std::vector<Collapse> collapses;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+            float cost = quadric_error(quadrics[a], vertices[b]);
+            if (kind[a] == VERTEX_MANIFOLD && cost <= max_error)
+                collapses.push_back(Collapse{a, b, UINT32_MAX, UINT32_MAX, cost});
+        }
+    }
+
+    // seam vertices slide along the seam, both wedges to the same point
+    for (uint32_t v = 0; v < vertex_count; v++)
+    {
+        if (kind[v] != VERTEX_SEAM)
+            continue;
+        uint32_t partner = wedges.partner[v];
+        for (uint32_t to : {open_next[v], open_prev[v]})
+        {
+            uint32_t seam_to = UINT32_MAX;
+            if (vertices[open_next[partner]] == vertices[to])
+                seam_to = open_next[partner];
+            else if (vertices[open_prev[partner]] == vertices[to])
+                seam_to = open_prev[partner];
+            if (seam_to == UINT32_MAX)
+                continue;
+
+            Quadric q = quadrics[v];
+            quadric_add(q, quadrics[partner]);
+            float cost = quadric_error(q, vertices[to]);
+            if (cost <= max_error)
+                collapses.push_back(Collapse{v, to, partner, seam_to, cost});
+        }
+    }
+
+    std::sort(collapses.begin(), collapses.end(), [](Collapse const &a, Collapse const &b)
+              { return a.error < b.error; });
+
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (auto index : indices)
+        offsets[index + 1]++;
+    for (size_t v = 0; v < vertex_count; v++)
+        offsets[v + 1] += offsets[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    std::vector<uint32_t> remap(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++)
+        remap[v] = (uint32_t)v;
+    std::vector<char> locked(vertex_count, 0);
+    auto lock_ring = [&](uint32_t v)
+    {
+        for (uint32_t i = offsets[v]; i < offsets[v + 1]; i++)
+        {
+            const uint32_t *tri = &indices[adjacency[i] * 3];
+            locked[tri[0]] = locked[tri[1]] = locked[tri[2]] = 1;
+        }
+    };
+
+    // a collapse removes two triangles, or four along a seam
+    size_t budget = (indices.size() - target_index_count) / 3;
+    size_t removed = 0;
+    size_t collapsed = 0;
+    for (auto const &collapse : collapses)
+    {
+        if (removed >= budget)
+            break;
+        bool seam = collapse.seam_from != UINT32_MAX;
+        if (locked[collapse.from] || locked[collapse.to])
+            continue;
+        if (seam && (locked[collapse.seam_from] || locked[collapse.seam_to]))
+            continue;
+        if (!collapse_valid(indices, vertices, wedges, offsets, adjacency, collapse.from, collapse.to))
+            continue;
+        if (seam && !collapse_valid(indices, vertices, wedges, offsets, adjacency, collapse.seam_from, collapse.seam_to))
+            continue;
+
+        remap[collapse.from] = collapse.to;
+        quadric_add(quadrics[collapse.to], quadrics[collapse.from]);
+        lock_ring(collapse.from);
+        if (seam)
+        {
+            remap[collapse.seam_from] = collapse.seam_to;
+            quadric_add(quadrics[collapse.seam_to], quadrics[collapse.seam_from]);
+            lock_ring(collapse.seam_from);
+        }
+        error = glm::max(error, collapse.error);
+        removed += 2;
+        collapsed++;
+    }
+
+    size_t write = 0;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+        if (a == b || b == c || a == c)
+            continue;
+        indices[write++] = a;
+        indices[write++] = b;
+        indices[write++] = c;
+    }
+    indices.resize(write);
+    return collapsed;
+}
+
+void build_lods(std::vector<uint32_t> &indices, std::vector<glm::vec3> const &vertices, std::vector<MeshLod> &lods, unsigned max_lods)
+{
+    size_t vertex_count = vertices.size();
+    lods.clear();
+    lods.push_back(MeshLod{0, (uint32_t)indices.size(), 0.0f});
+
+    Wedges wedges;
+    wedges.position.resize(vertex_count);
+    wedges.count.assign(vertex_count, 1);
+    wedges.partner.assign(vertex_count, UINT32_MAX);
+    {
+        std::unordered_map<glm::vec3, uint32_t, PositionHash> first;
+        first.reserve(vertex_count);
+        for (uint32_t v = 0; v < vertex_count; v++)
+        {
+            auto inserted = first.emplace(vertices[v], v);
+            if (!inserted.second)
+            {
+                uint32_t head = inserted.first->second;
+                wedges.partner[head] = v;
+                wedges.partner[v] = head;
+                wedges.count[head]++;
+            }
+        }
+        for (uint32_t v = 0; v < vertex_count; v++)
+        {
+            wedges.position[v] = first[vertices[v]];
+            wedges.count[v] = wedges.count[wedges.position[v]];
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertex_count, Quadric{});
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        Quadric q = plane_quadric(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]);
+        for (int k = 0; k < 3; k++)
+            quadric_add(quadrics[indices[i + k]], q);
+    }
+
+    glm::vec3 min(INFINITY), max(-INFINITY);
+    for (const auto &vertex : vertices)
+    {
+        min = glm::min(min, vertex);
+        max = glm::max(max, vertex);
+    }
+    glm::vec3 extent = max - min;
+    float scale = glm::max(extent.x, glm::max(extent.y, extent.z));
+    float max_error = MESH_LOD_MAX_ERROR * scale * MESH_LOD_MAX_ERROR * scale;
+
+    std::vector<uint32_t> current(indices);
+    float error = 0.0f;
+    while (lods.size() < max_lods)
+    {
+        size_t previous = current.size();
+        size_t target = (size_t)(previous / 3 * MESH_LOD_RATIO) * 3;
+        while (current.size() > target && collapse_pass(current, vertices, wedges, quadrics, target, max_error, error))
+            ;
+
+        if (current.empty() || current.size() > previous * 0.9f)
+            break;
+
+        std::vector<uint32_t> level(current);
+        optimize_vertex_cache(level, vertex_count);
+        lods.push_back(MeshLod{(uint32_t)indices.size(), (uint32_t)level.size(), scale > 0.0f ? sqrtf(error) / scale : 0.0f});
+        indices.insert(indices.end(), level.begin(), level.end());
+    }
+}
+
+static inline float sign_not_zero(float v)
+{
+    return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+static glm::vec2 octahedral_encode(glm::vec3 n)
+{
+    float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    if (l1 == 0.0f)
+        return glm::vec2(0.0f);
+    n /= l1;
+    if (n.z >= 0.0f)
+        return glm::vec2(n.x, n.y);
+    return glm::vec2((1.0f - fabsf(n.y)) * sign_not_zero(n.x), (1.0f - fabsf(n.x)) * sign_not_zero(n.y));
+}
+
+static glm::vec3 octahedral_decode(glm::vec2 e)
+{
+    glm::vec3 n(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+    if (n.z < 0.0f)
+    {
+        float x = n.x;
+        n.x = (1.0f - fabsf(n.y)) * sign_not_zero(x);
+        n.y = (1.0f - fabsf(x)) * sign_not_zero(n.y);
+    }
+    return glm::normalize(n);
+}
+
+static inline glm::vec3 position_scale(glm::vec3 const &min, glm::vec3 const &max)
+{
+    glm::vec3 extent = max - min;
+    return glm::vec3(extent.x > 0.0f ? extent.x : 1.0f, extent.y > 0.0f ? extent.y : 1.0f, extent.z > 0.0f ? extent.z : 1.0f);
+}
+
+void quantize_streams(std::vector<glm::vec3> const &vertices, std::vector<glm::vec2> const &uvs, std::vector<glm::vec3> const &normals,
+                      glm::vec3 const &min, glm::vec3 const &max, QuantizedStreams &out)
+{
+    size_t count = vertices.size();
+    glm::vec3 scale = position_scale(min, max);
+
+    out.positions.resize(count);
+    out.uvs.resize(count);
+    out.normals.resize(count);
+    out.position_error = 0.0f;
+    out.uv_error = 0.0f;
+    out.normal_error = 0.0f;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec3 unit = glm::clamp((vertices[i] - min) / scale, 0.0f, 1.0f);
+        glm::u16vec3 q = glm::u16vec3(glm::round(unit * 65535.0f));
+        out.positions[i] = glm::u16vec4(q, 0);
+        glm::vec3 decoded = min + glm::vec3(q) / 65535.0f * scale;
+        glm::vec3 error = glm::abs(decoded - vertices[i]);
+        out.position_error = glm::max(out.position_error, glm::max(error.x, glm::max(error.y, error.z)));
+
+        out.uvs[i] = glm::packHalf2x16(uvs[i]);
+        glm::vec2 uv_error = glm::abs(glm::unpackHalf2x16(out.uvs[i]) - uvs[i]);
+        out.uv_error = glm::max(out.uv_error, glm::max(uv_error.x, uv_error.y));
+
+        out.normals[i] = glm::packSnorm2x16(octahedral_encode(normals[i]));
+        float length = glm::length(normals[i]);
+        if (length > 0.0f)
+        {
+            glm::vec3 n = octahedral_decode(glm::unpackSnorm2x16(out.normals[i]));
+            float cosine = glm::clamp(glm::dot(n, normals[i] / length), -1.0f, 1.0f);
+            out.normal_error = glm::max(out.normal_error, glm::degrees(acosf(cosine)));
+        }
+    }
+}
+
+void dequantize_streams(size_t vertex_count, glm::u16vec4 const *positions, uint32_t const *uvs, uint32_t const *normals, glm::vec3 const &min, glm::vec3 const &max,
+                        std::vector<glm::vec3> &out_vertices, std::vector<glm::vec2> &out_uvs, std::vector<glm::vec3> &out_normals)
+{
+    glm::vec3 scale = position_scale(min, max);
+    out_vertices.resize(vertex_count);
+    out_uvs.resize(vertex_count);
+    out_normals.resize(vertex_count);
+
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+        out_vertices[i] = min + glm::vec3(glm::u16vec3(positions[i])) / 65535.0f * scale;
+        out_uvs[i] = glm::unpackHalf2x16(uvs[i]);
+        out_normals[i] = octahedral_decode(glm::unpackSnorm2x16(normals[i]));
+    }
+}
+
+glm::mat4 dequantize_matrix(glm::vec3 const &min, glm::vec3 const &max)
+{
+    return glm::scale(glm::translate(glm::mat4(1.0f), min), position_scale(min, max));
+}
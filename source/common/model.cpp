@@ -1,184 +1,29 @@
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
+#include "impl_base.hpp"
+#include "instancing.hpp"
 #include "model.hpp"
+#include "update.hpp"
 
-Model::Model(GLuint matrix_id, GLuint color_id, std::vector<glm::vec3> const &vertices, std::vector<glm::vec2> const &uvs, std::vector<glm::vec3> const &normals, const char *label)
-    : matrix_id(matrix_id), color_id(color_id), vertices(vertices), uvs(uvs), normals(normals), label(label)
+Model::Model(Program *program, std::shared_ptr<Mesh> mesh, const char *label)
+    : program(program), mesh(mesh), label(label)
 {
-    glGenBuffers(1, &vertex_buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), &this->vertices[0], GL_STATIC_DRAW);
-
-    glm::vec3 min = {INFINITY, INFINITY, INFINITY};
-    glm::vec3 max = {-INFINITY, -INFINITY, -INFINITY};
-
-    for (const auto &vertex : vertices)
-    {
-        if (vertex.x < min.x)
-            min.x = vertex.x;
-        if (vertex.y < min.y)
-            min.y = vertex.y;
-        if (vertex.z < min.z)
-            min.z = vertex.z;
-
-        if (vertex.x > max.x)
-            max.x = vertex.x;
-        if (vertex.y > max.y)
-            max.y = vertex.y;
-        if (vertex.z > max.z)
-            max.z = vertex.z;
-    }
-
-    box.min = min;
-    box.max = max;
-
+    box = mesh->bounds;
     original_box = box;
 }
 
-void Model::draw(glm::mat4 const &view_projection)
+MeshLod const &Model::select_lod(glm::mat4 const &view_projection) const
 {
-    if (texture_id)
-        glUseProgram(program_id);
-
-    auto mvp = view_projection * matrix;
-    glUniformMatrix4fv(matrix_id, 1, GL_FALSE, &mvp[0][0]);
-    glUniform4f(color_id, color.r, color.g, color.b, color.a);
-
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-    glVertexAttribPointer(
-        0,        // attribute
-        3,        // size
-        GL_FLOAT, // type
-        GL_FALSE, // normalized?
-        0,        // stride
-        (void *)0 // array buffer offset
-    );
-
-    if (texture_id)
-    {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_id);
-        glEnableVertexAttribArray(1);
-        glBindBuffer(GL_ARRAY_BUFFER, uv_buffer);
-        glVertexAttribPointer(
-            1,
-            2,
-            GL_FLOAT,
-            GL_FALSE,
-            0,
-            (void *)0);
-    }
-
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size());
-
-    glDisableVertexAttribArray(0);
-
-    if (texture_id)
-        glDisableVertexAttribArray(1);
+    return mesh->select_lod(projected_size(box, view_projection, width, height));
 }
 
-Model *Model::from_obj(GLuint matrix_id, GLuint color_id, const char *path, const char *label)
+Model *Model::from_obj(Program *program, const char *path, const char *label)
 {
-    printf("Loading OBJ file %s...\n", path);
-
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec2> uvs;
-    std::vector<glm::vec3> normals;
-
-    std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-    std::vector<glm::vec3> temp_vertices;
-    std::vector<glm::vec2> temp_uvs;
-    std::vector<glm::vec3> temp_normals;
-
-    FILE *file = fopen(path, "r");
-    if (file == NULL)
-    {
-        printf("Impossible to open the file ! Are you in the right path ? See Tutorial 1 for details\n");
-        exit(1);
-    }
-
-    while (1)
-    {
-
-        char lineHeader[128];
-        // read the first word of the line
-        int res = fscanf(file, "%s", lineHeader);
-        if (res == EOF)
-            break; // EOF = End Of File. Quit the loop.
-
-        // else : parse lineHeader
-
-        if (strcmp(lineHeader, "v") == 0)
-        {
-            glm::vec3 vertex;
-            fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
-            temp_vertices.push_back(vertex);
-        }
-        else if (strcmp(lineHeader, "vt") == 0)
-        {
-            glm::vec2 uv;
-            fscanf(file, "%f %f\n", &uv.x, &uv.y);
-            uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
-            temp_uvs.push_back(uv);
-        }
-        else if (strcmp(lineHeader, "vn") == 0)
-        {
-            glm::vec3 normal;
-            fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-            temp_normals.push_back(normal);
-        }
-        else if (strcmp(lineHeader, "f") == 0)
-        {
-            unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-            int matches = fscanf(file, "%u/%u/%u %u/%u/%u %u/%u/%u\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-            if (matches != 9)
-            {
-                printf("File can't be read by our simple parser :-( Try exporting with other options\n");
-                fclose(file);
-                exit(1);
-            }
-            vertexIndices.push_back(vertexIndex[0]);
-            vertexIndices.push_back(vertexIndex[1]);
-            vertexIndices.push_back(vertexIndex[2]);
-            uvIndices.push_back(uvIndex[0]);
-            uvIndices.push_back(uvIndex[1]);
-            uvIndices.push_back(uvIndex[2]);
-            normalIndices.push_back(normalIndex[0]);
-            normalIndices.push_back(normalIndex[1]);
-            normalIndices.push_back(normalIndex[2]);
-        }
-        else
-        {
-            // Probably a comment, eat up the rest of the line
-            char stupidBuffer[1000];
-            fgets(stupidBuffer, 1000, file);
-        }
-    }
-
-    // For each vertex of each triangle
-    for (unsigned int i = 0; i < vertexIndices.size(); i++)
-    {
-
-        // Get the indices of its attributes
-        unsigned int vertexIndex = vertexIndices[i];
-        unsigned int uvIndex = uvIndices[i];
-        unsigned int normalIndex = normalIndices[i];
-
-        // Get the attributes thanks to the index
-        glm::vec3 vertex = temp_vertices[vertexIndex - 1];
-        glm::vec2 uv = temp_uvs[uvIndex - 1];
-        glm::vec3 normal = temp_normals[normalIndex - 1];
-
-        // Put the attributes in buffers
-        vertices.push_back(vertex);
-        uvs.push_back(uv);
-        normals.push_back(normal);
-    }
-    fclose(file);
+    return new Model(program, load_mesh_async(path), label);
+}
 
-    return new Model(matrix_id, color_id, vertices, uvs, normals, label);
+void Model::refresh_box()
+{
+    original_box = mesh->bounds;
+    box = calc_transformed_bounds(original_box, matrix);
 }
 
 void Model::move_by(glm::vec3 const &coords)
@@ -204,25 +49,12 @@ void update_model(Model *model)
     arrows[1]->move_to(glm::vec3(xyz.x, xyz.y + 0.29f, xyz.z));
     arrows[2]->move_to(glm::vec3(xyz.x, xyz.y, xyz.z + 0.29f));
     model->box = calc_transformed_bounds(model->original_box, model->matrix);
+    mark_dirty();
 }
 
 void Model::texture_from_file(const char *path)
 {
-    int x, y, c;
-    void *earth = stbi_load("assets/earth.jpg", &x, &y, &c, 0);
-
-    glGenBuffers(1, &uv_buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, uv_buffer);
-    glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(float) * 2, &uvs[0], GL_STATIC_DRAW);
-
-    glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, x, y, 0, GL_RGB, GL_UNSIGNED_BYTE, earth);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-    program_id = load_shaders("source/shaders/texture.vert.glsl", "source/shaders/texture.frag.glsl");
-    matrix_id = glGetUniformLocation(program_id, "u_mvp");
-    time_id = glGetUniformLocation(program_id, "u_time");
-    color_id = glGetUniformLocation(program_id, "u_color");
+    // one program serves every textured model, compiled by the time it is drawn
+    program = request_program("source/shaders/texture.vert.glsl", "source/shaders/texture.frag.glsl", INSTANCED_DEFINES);
+    texture = load_texture(path);
 }
@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <thread>
+#include <unordered_map>
+
+#include "gom.hpp"
+#include "io.hpp"
+#include "obj.hpp"
+
+static const double pow10_table[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static inline bool is_digit(uint8_t c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool is_blank(uint8_t c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const uint8_t *skip_blank(const uint8_t *p, const uint8_t *end)
+{
+    while (p < end && is_blank(*p))
+        p++;
+    return p;
+}
+
+static inline const uint8_t *skip_line(const uint8_t *p, const uint8_t *end)
+{
+    const uint8_t *nl = (const uint8_t *)memchr(p, '\n', end - p);
+    return nl ? nl + 1 : end;
+}
+
+// Returns 0 if no number could be read at p. Up to 19 significant digits
+// are kept, which is plenty for the 6 decimals exporters usually write.
+static const uint8_t *parse_float(const uint8_t *p, const uint8_t *end, float &out)
+{
+    p = skip_blank(p, end);
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+
+    for (; p < end && is_digit(*p); p++, any = true)
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        }
+        else
+            exponent++;
+    }
+
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && is_digit(*p); p++, any = true)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+
+    if (!any)
+        return 0;
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const uint8_t *q = p + 1;
+        bool exp_negative = false;
+        if (q < end && (*q == '-' || *q == '+'))
+            exp_negative = *q++ == '-';
+        if (q < end && is_digit(*q))
+        {
+            int e = 0;
+            for (; q < end && is_digit(*q); q++)
+                if (e < 10000)
+                    e = e * 10 + (*q - '0');
+            exponent += exp_negative ? -e : e;
+            p = q;
+        }
+    }
+
+    double value = (double)mantissa;
+    if (exponent < 0)
+        value = exponent >= -22 ? value / pow10_table[-exponent] : value * pow(10.0, exponent);
+    else if (exponent > 0)
+        value = exponent <= 22 ? value * pow10_table[exponent] : value * pow(10.0, exponent);
+
+    out = (float)(negative ? -value : value);
+    return p;
+}
+
+static inline const uint8_t *parse_int(const uint8_t *p, const uint8_t *end, int64_t &out)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    if (p == end || !is_digit(*p))
+        return 0;
+    int64_t value = 0;
+    for (; p < end && is_digit(*p); p++)
+    {
+        // past int32 it is out of range anyway, stop before int64 overflows
+        if (value <= INT32_MAX)
+            value = value * 10 + (*p - '0');
+    }
+    out = negative ? -value : value;
+    return p;
+}
+
+// OBJ indices are 1-based, negative ones count back from the last element
+static inline bool resolve_index(int64_t index, size_t count, int32_t &out)
+{
+    if (index > INT32_MAX)
+        return false;
+    if (index > 0)
+        out = (int32_t)(index - 1);
+    else if (index < 0 && (size_t)-index <= count)
+        out = (int32_t)(count + index);
+    else
+        return false;
+    return true;
+}
+
+static const uint8_t *parse_corner(const uint8_t *p, const uint8_t *end, ObjCounts const &seen, ObjCorner &corner)
+{
+    int64_t index;
+    corner.vt = -1;
+    corner.vn = -1;
+
+    if (!(p = parse_int(p, end, index)) || !resolve_index(index, seen.positions, corner.v))
+        return 0;
+    if (p < end && *p == '/')
+    {
+        p++;
+        if (p < end && *p != '/')
+        {
+            if (!(p = parse_int(p, end, index)) || !resolve_index(index, seen.uvs, corner.vt))
+                return 0;
+        }
+        if (p < end && *p == '/')
+        {
+            p++;
+            if (!(p = parse_int(p, end, index)) || !resolve_index(index, seen.normals, corner.vn))
+                return 0;
+        }
+    }
+    return p;
+}
+
+static inline bool at_token_end(const uint8_t *p, const uint8_t *end)
+{
+    return p == end || is_blank(*p) || *p == '\n';
+}
+
+ObjCounts count_obj(const uint8_t *data, size_t size)
+{
+    ObjCounts counts = {0, 0, 0, 0, 0};
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+
+    while (p < end)
+    {
+        counts.lines++;
+        p = skip_blank(p, end);
+        if (end - p >= 2 && p[0] == 'v')
+        {
+            if (is_blank(p[1]))
+                counts.positions++;
+            else if (p[1] == 't')
+                counts.uvs++;
+            else if (p[1] == 'n')
+                counts.normals++;
+        }
+        else if (end - p >= 2 && p[0] == 'f' && is_blank(p[1]))
+        {
+            size_t tokens = 0;
+            for (p++; p < end && *p != '\n';)
+            {
+                p = skip_blank(p, end);
+                if (p == end || *p == '\n')
+                    break;
+                tokens++;
+                while (!at_token_end(p, end))
+                    p++;
+            }
+            if (tokens >= 3)
+                counts.corners += (tokens - 2) * 3;
+        }
+        p = skip_line(p, end);
+    }
+
+    return counts;
+}
+
+// Parses [p, end) into the pre-sized arrays of obj. at holds the offsets
+// this range starts writing at, which are also the element counts of
+// everything before it, so relative indices resolve globally.
+static bool parse_range(const uint8_t *p, const uint8_t *end, ObjData &obj, ObjCounts at)
+{
+    size_t first_corner = at.corners;
+
+    while (p < end)
+    {
+        at.lines++;
+        p = skip_blank(p, end);
+        if (end - p >= 2 && p[0] == 'v' && is_blank(p[1]))
+        {
+            glm::vec3 &v = obj.positions[at.positions++];
+            if (!(p = parse_float(p + 1, end, v.x)) || !(p = parse_float(p, end, v.y)) || !(p = parse_float(p, end, v.z)))
+            {
+                error("malformed vertex on line %zu", at.lines);
+                return false;
+            }
+        }
+        else if (end - p >= 2 && p[0] == 'v' && p[1] == 't')
+        {
+            glm::vec2 &uv = obj.uvs[at.uvs++];
+            if (!(p = parse_float(p + 2, end, uv.x)) || !(p = parse_float(p, end, uv.y)))
+            {
+                error("malformed texture coordinate on line %zu", at.lines);
+                return false;
+            }
+        }
+        else if (end - p >= 2 && p[0] == 'v' && p[1] == 'n')
+        {
+            glm::vec3 &n = obj.normals[at.normals++];
+            if (!(p = parse_float(p + 2, end, n.x)) || !(p = parse_float(p, end, n.y)) || !(p = parse_float(p, end, n.z)))
+            {
+                error("malformed normal on line %zu", at.lines);
+                return false;
+            }
+        }
+        else if (end - p >= 2 && p[0] == 'f' && is_blank(p[1]))
+        {
+            ObjCorner first = {}, prev = {}, corner;
+            size_t n = 0;
+            for (p++;; n++)
+            {
+                p = skip_blank(p, end);
+                if (p == end || *p == '\n')
+                    break;
+                if (!(p = parse_corner(p, end, at, corner)) || !at_token_end(p, end))
+                {
+                    error("malformed face on line %zu", at.lines);
+                    return false;
+                }
+                if (n == 0)
+                    first = corner;
+                else if (n >= 2)
+                {
+                    obj.corners[at.corners++] = first;
+                    obj.corners[at.corners++] = prev;
+                    obj.corners[at.corners++] = corner;
+                }
+                prev = corner;
+            }
+            if (n < 3)
+            {
+                error("face with %zu vertices on line %zu", n, at.lines);
+                return false;
+            }
+        }
+        p = skip_line(p, end);
+    }
+
+    for (size_t i = first_corner; i < at.corners; i++)
+    {
+        const auto &c = obj.corners[i];
+        if ((size_t)c.v >= obj.positions.size() ||
+            (c.vt >= 0 && (size_t)c.vt >= obj.uvs.size()) ||
+            (c.vn >= 0 && (size_t)c.vn >= obj.normals.size()))
+        {
+            error("face index out of range (%d/%d/%d)", c.v + 1, c.vt + 1, c.vn + 1);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void resize_obj(ObjData &obj, ObjCounts const &total)
+{
+    obj.positions.resize(total.positions);
+    obj.uvs.resize(total.uvs);
+    obj.normals.resize(total.normals);
+    obj.corners.resize(total.corners);
+}
+
+bool parse_obj(const uint8_t *data, size_t size, ObjData &obj)
+{
+    resize_obj(obj, count_obj(data, size));
+    return parse_range(data, data + size, obj, ObjCounts{0, 0, 0, 0, 0});
+}
+
+bool parse_obj_parallel(const uint8_t *data, size_t size, ObjData &obj, unsigned threads)
+{
+#ifdef __EMSCRIPTEN__
+    threads = 1;
+#else
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned)std::min<size_t>(threads, size / OBJ_MIN_CHUNK_SIZE);
+#endif // __EMSCRIPTEN__
+    if (threads <= 1)
+        return parse_obj(data, size, obj);
+
+    // split at newlines so that no record straddles two chunks
+    std::vector<const uint8_t *> bounds(threads + 1);
+    bounds[0] = data;
+    bounds[threads] = data + size;
+    for (unsigned i = 1; i < threads; i++)
+        bounds[i] = std::max(bounds[i - 1], skip_line(data + size / threads * i, data + size));
+
+    std::vector<ObjCounts> offsets(threads + 1);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back([&, i]
+                             { offsets[i + 1] = count_obj(bounds[i], bounds[i + 1] - bounds[i]); });
+    for (auto &worker : workers)
+        worker.join();
+    workers.clear();
+
+    offsets[0] = ObjCounts{0, 0, 0, 0, 0};
+    for (unsigned i = 1; i <= threads; i++)
+    {
+        offsets[i].positions += offsets[i - 1].positions;
+        offsets[i].uvs += offsets[i - 1].uvs;
+        offsets[i].normals += offsets[i - 1].normals;
+        offsets[i].corners += offsets[i - 1].corners;
+        offsets[i].lines += offsets[i - 1].lines;
+    }
+    resize_obj(obj, offsets[threads]);
+
+    std::vector<char> ok(threads);
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back([&, i]
+                             { ok[i] = parse_range(bounds[i], bounds[i + 1], obj, offsets[i]); });
+    for (auto &worker : workers)
+        worker.join();
+
+    return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
+
+bool load_obj(const char *path, ObjData &obj, uint64_t *hash)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    File file = open_and_map_file(path, IO_READ_ONLY);
+    bool ok = parse_obj_parallel(file.start, file.size, obj);
+    if (hash)
+        *hash = gom_hash(file.start, file.size);
+    size_t size = file.size;
+    UNMAP_AND_CLOSE_FILE(file);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (ok)
+        printf("Parsed %s: %.2f MB in %.2f ms (%.1f MB/s)\n", path, size / 1e6, ms, ms > 0.0 ? size / 1e3 / ms : 0.0);
+    return ok;
+}
+
+struct ObjCornerHash
+{
+    size_t operator()(ObjCorner const &c) const
+    {
+        uint64_t h = (uint64_t)(uint32_t)c.v * 0x9E3779B97F4A7C15ull;
+        h ^= ((uint64_t)(uint32_t)c.vt + (h << 6) + (h >> 2)) * 0xC2B2AE3D27D4EB4Full;
+        h ^= ((uint64_t)(uint32_t)c.vn + (h << 6) + (h >> 2)) * 0x165667B19E3779F9ull;
+        return (size_t)(h ^ (h >> 29));
+    }
+};
+
+struct ObjCornerEqual
+{
+    bool operator()(ObjCorner const &a, ObjCorner const &b) const
+    {
+        return a.v == b.v && a.vt == b.vt && a.vn == b.vn;
+    }
+};
+
+void weld_obj(ObjData const &obj, std::vector<glm::vec3> &vertices, std::vector<glm::vec2> &uvs, std::vector<glm::vec3> &normals, std::vector<uint32_t> &indices)
+{
+    std::unordered_map<ObjCorner, uint32_t, ObjCornerHash, ObjCornerEqual> unique;
+    unique.reserve(obj.positions.size() * 2);
+
+    vertices.clear();
+    uvs.clear();
+    normals.clear();
+    indices.resize(obj.corners.size());
+
+    for (size_t i = 0; i < obj.corners.size(); i++)
+    {
+        const auto &corner = obj.corners[i];
+        auto it = unique.emplace(corner, (uint32_t)vertices.size());
+        if (it.second)
+        {
+            vertices.push_back(obj.positions[corner.v]);
+            uvs.push_back(corner.vt >= 0 ? obj.uvs[corner.vt] : glm::vec2(0.0f));
+            normals.push_back(corner.vn >= 0 ? obj.normals[corner.vn] : glm::vec3(0.0f));
+        }
+        indices[i] = it.first->second;
+    }
+}
@@ -0,0 +1,143 @@
+#include <string.h>
+
+#include <memory>
+
+#include "frame_ring.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "occlusion.hpp"
+
+#ifndef GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+#define GL_ANY_SAMPLES_PASSED_CONSERVATIVE 0x8D6A
+#endif // GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+
+static uint32_t frame = 0;
+static GLenum target = 0;
+static Program *proxy_program = NULL;
+// the unit cube Mesh stands in for every box
+static std::shared_ptr<Mesh> proxy;
+static std::vector<uint32_t> due;
+
+// Conservative where the driver has it, it may pass a few more samples
+// but never reports a visible box occluded
+static GLenum query_target()
+{
+#ifdef __EMSCRIPTEN__
+    return GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+#else
+    if (GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility)
+        return GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+    if (GLEW_VERSION_3_3 || GLEW_ARB_occlusion_query2)
+        return GL_ANY_SAMPLES_PASSED;
+    return GL_SAMPLES_PASSED;
+#endif // __EMSCRIPTEN__
+}
+
+bool occlusion_cull(Model *const *models, std::vector<uint32_t> const &in_view, std::vector<uint32_t> &drawn, glm::vec3 const &eye, uint32_t scene)
+{
+    frame++;
+    drawn.clear();
+    bool unsettled = false;
+    for (uint32_t index : in_view)
+    {
+        Model *model = models[index];
+        OcclusionQuery &query = model->occlusion;
+        if (query.seen + 1 != frame)
+        {
+            // back in view, whatever was measured before is stale
+            query.pending = false;
+            query.visible = true;
+        }
+        query.seen = frame;
+
+        if (query.pending)
+        {
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available)
+            {
+                GLuint samples = 0;
+                glGetQueryObjectuiv(query.id, GL_QUERY_RESULT, &samples);
+                unsettled |= query.visible != (samples > 0);
+                query.visible = samples > 0;
+                query.pending = false;
+                query.measured = query.issued;
+            }
+        }
+        // the proxy is clipped by the near plane from inside
+        if (intersect(eye, model->box))
+            query.visible = true;
+
+        if (query.visible)
+            drawn.push_back(index);
+        // hidden by a result from before the last change, it may show up again
+        else if (query.measured != scene)
+            unsettled = true;
+    }
+    return unsettled;
+}
+
+void occlusion_query(Model *const *models, std::vector<uint32_t> const &in_view, glm::mat4 const &view_projection, glm::vec3 const &eye, uint32_t scene)
+{
+    if (!proxy)
+    {
+        target = query_target();
+        proxy_program = request_program("source/shaders/color.vert.glsl", "source/shaders/color.frag.glsl");
+        proxy = std::make_shared<Mesh>();
+    }
+
+    due.clear();
+    for (uint32_t index : in_view)
+    {
+        Model *model = models[index];
+        OcclusionQuery const &query = model->occlusion;
+        if (query.pending || intersect(eye, model->box))
+            continue;
+        if (query.visible && (frame + index) % OCCLUSION_VISIBLE_INTERVAL != 0)
+            continue;
+        due.push_back(index);
+    }
+    if (due.empty())
+        return;
+
+    // every proxy's constants in one span, a range of it bound per query
+    size_t stride = (sizeof(ObjectConstants) + uniform_alignment() - 1) & ~(uniform_alignment() - 1);
+    FrameSpan constants = frame_alloc(due.size() * stride, uniform_alignment());
+    for (size_t i = 0; i < due.size(); i++)
+    {
+        AABB const &box = models[due[i]]->box;
+        glm::mat4 matrix = glm::translate(glm::mat4(1.0f), (box.min + box.max) * 0.5f);
+        // a little larger so a model's own faces on its box never hide the proxy
+        matrix = glm::scale(matrix, (box.max - box.min) * 1.01f + 0.01f);
+        ObjectConstants object = {};
+        object.mvp = view_projection * matrix;
+        memcpy(constants.data + i * stride, &object, sizeof(ObjectConstants));
+    }
+    frame_flush(constants);
+
+    // depth tested only, both sides in case the camera is close
+    use_program(*proxy_program);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+    glBindVertexArray(proxy->vertex_array);
+
+    for (size_t i = 0; i < due.size(); i++)
+    {
+        OcclusionQuery &query = models[due[i]]->occlusion;
+        if (!query.id)
+            glGenQueries(1, &query.id);
+        glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, constants.buffer, constants.offset + i * stride, sizeof(ObjectConstants));
+        glBeginQuery(target, query.id);
+        glDrawElements(GL_TRIANGLES, proxy->lods[0].index_count, proxy->index_type, (void *)0);
+        glEndQuery(target);
+        query.pending = true;
+        query.issued = scene;
+    }
+
+    glBindVertexArray(0);
+    glEnable(GL_CULL_FACE);
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glUseProgram(0);
+}
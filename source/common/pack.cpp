@@ -0,0 +1,340 @@
+#include <mutex>
+#include <unordered_map>
+
+#include "embedded.hpp"
+#include "gom.hpp"
+#include "io.hpp"
+#include "pack.hpp"
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_HASH_BITS 14
+#define LZ4_MAX_OFFSET 0xFFFF
+// the format keeps the tail as literals
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_LIMIT 12
+
+static File pack_file;
+static const GpkHeader *pack = NULL;
+// compressed entries are inflated on first use and kept until unmount
+static std::mutex inflated_mutex;
+static std::unordered_map<uint32_t, std::vector<uint8_t>> inflated;
+
+static inline uint64_t align_up(uint64_t offset)
+{
+    return (offset + GPK_ALIGNMENT - 1) & ~(uint64_t)(GPK_ALIGNMENT - 1);
+}
+
+static uint64_t path_hash(const char *path, size_t size)
+{
+    return gom_hash((const uint8_t *)path, size);
+}
+
+static void lz4_length(std::vector<uint8_t> &dst, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        dst.push_back(255);
+    dst.push_back((uint8_t)length);
+}
+
+static void lz4_sequence(std::vector<uint8_t> &dst, const uint8_t *literals, size_t literal_count, size_t offset, size_t match)
+{
+    size_t match_code = match ? match - LZ4_MIN_MATCH : 0;
+    dst.push_back((uint8_t)((literal_count < 15 ? literal_count : 15) << 4 | (match_code < 15 ? match_code : 15)));
+    if (literal_count >= 15)
+        lz4_length(dst, literal_count - 15);
+    dst.insert(dst.end(), literals, literals + literal_count);
+    if (!match)
+        return;
+    dst.push_back((uint8_t)offset);
+    dst.push_back((uint8_t)(offset >> 8));
+    if (match_code >= 15)
+        lz4_length(dst, match_code - 15);
+}
+
+size_t lz4_compress(const uint8_t *src, size_t size, std::vector<uint8_t> &dst)
+{
+    dst.clear();
+    dst.reserve(size + size / 255 + 16);
+    std::vector<uint32_t> table(1 << LZ4_HASH_BITS, UINT32_MAX);
+
+    size_t anchor = 0;
+    size_t limit = size > LZ4_MATCH_LIMIT ? size - LZ4_MATCH_LIMIT : 0;
+    size_t i = 0;
+    while (i < limit)
+    {
+        uint32_t sequence;
+        memcpy(&sequence, src + i, 4);
+        uint32_t h = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        uint32_t candidate = table[h];
+        table[h] = (uint32_t)i;
+
+        if (candidate == UINT32_MAX || i - candidate > LZ4_MAX_OFFSET || memcmp(src + candidate, src + i, 4) != 0)
+        {
+            i++;
+            continue;
+        }
+
+        size_t match = LZ4_MIN_MATCH;
+        while (i + match < size - LZ4_LAST_LITERALS && src[candidate + match] == src[i + match])
+            match++;
+        lz4_sequence(dst, src + anchor, i - anchor, i - candidate, match);
+        i += match;
+        anchor = i;
+    }
+    lz4_sequence(dst, src + anchor, size - anchor, 0, 0);
+    return dst.size();
+}
+
+static bool lz4_read_length(const uint8_t *src, size_t size, size_t &s, size_t &length)
+{
+    uint8_t byte;
+    do
+    {
+        if (s >= size)
+            return false;
+        byte = src[s++];
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool lz4_decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_size)
+{
+    size_t s = 0, d = 0;
+    while (s < size)
+    {
+        uint8_t token = src[s++];
+        size_t literal_count = token >> 4;
+        if (literal_count == 15 && !lz4_read_length(src, size, s, literal_count))
+            return false;
+        if (literal_count > size - s || literal_count > dst_size - d)
+            return false;
+        memcpy(dst + d, src + s, literal_count);
+        s += literal_count;
+        d += literal_count;
+        if (s == size)
+            break; // the last sequence has no match
+
+        if (size - s < 2)
+            return false;
+        size_t offset = src[s] | (size_t)src[s + 1] << 8;
+        s += 2;
+        size_t match = token & 15;
+        if (match == 15 && !lz4_read_length(src, size, s, match))
+            return false;
+        match += LZ4_MIN_MATCH;
+        if (offset == 0 || offset > d || match > dst_size - d)
+            return false;
+        // may overlap itself, so byte by byte
+        for (size_t i = 0; i < match; i++, d++)
+            dst[d] = dst[d - offset];
+    }
+    return d == dst_size;
+}
+
+bool pack_write(const char *path, std::vector<PackInput> const &inputs)
+{
+    uint32_t slot_count = 1;
+    while (slot_count < inputs.size() * 2)
+        slot_count *= 2;
+
+    // compress first, the layout depends on the stored sizes
+    std::vector<std::vector<uint8_t>> compressed(inputs.size());
+    std::vector<GpkEntry> entries(inputs.size());
+    std::vector<uint32_t> slots(slot_count, GPK_EMPTY);
+    std::string paths;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        PackInput const &input = inputs[i];
+        GpkEntry &entry = entries[i];
+        memset(&entry, 0, sizeof(GpkEntry));
+        entry.hash = path_hash(input.path.data(), input.path.size());
+        entry.path_offset = (uint32_t)paths.size();
+        entry.path_size = (uint32_t)input.path.size();
+        entry.raw_size = input.size;
+        entry.size = input.size;
+        entry.compression = GPK_STORED;
+        paths += input.path;
+
+        if (input.compress && lz4_compress(input.data, input.size, compressed[i]) <= input.size - input.size / 4)
+        {
+            entry.size = compressed[i].size();
+            entry.compression = GPK_LZ4;
+        }
+        else
+            compressed[i].clear();
+
+        uint32_t slot = (uint32_t)entry.hash & (slot_count - 1);
+        for (; slots[slot] != GPK_EMPTY; slot = (slot + 1) & (slot_count - 1))
+        {
+            GpkEntry const &other = entries[slots[slot]];
+            if (other.hash == entry.hash && inputs[slots[slot]].path == input.path)
+            {
+                error("%s is packed twice", input.path.c_str());
+                return false;
+            }
+        }
+        slots[slot] = (uint32_t)i;
+    }
+
+    GpkHeader header;
+    memset(&header, 0, sizeof(GpkHeader));
+    header.magic = GPK_MAGIC;
+    header.version = GPK_VERSION;
+    header.entry_count = (uint32_t)inputs.size();
+    header.slot_count = slot_count;
+    header.slots_offset = align_up(sizeof(GpkHeader));
+    header.entries_offset = align_up(header.slots_offset + slot_count * sizeof(uint32_t));
+    header.paths_offset = header.entries_offset + entries.size() * sizeof(GpkEntry);
+    uint64_t size = align_up(header.paths_offset + paths.size());
+    for (auto &entry : entries)
+    {
+        entry.offset = size;
+        size = align_up(size + entry.size);
+    }
+
+    // write to a temporary and rename so a crash never leaves a torn pack
+    std::string temp_path = std::string(path) + ".tmp";
+    File file = open_or_create_file(temp_path.c_str(), IO_READ_WRITE, 1);
+    if (file.handle == IO_BAD_FILE_HANDLE)
+        return false;
+    if (!truncate_file(&file, size) || !map_file(&file))
+    {
+        close_file(file);
+        remove(temp_path.c_str());
+        return false;
+    }
+
+    memset(file.start, 0, size);
+    memcpy(file.start, &header, sizeof(GpkHeader));
+    memcpy(file.start + header.slots_offset, slots.data(), slots.size() * sizeof(uint32_t));
+    memcpy(file.start + header.entries_offset, entries.data(), entries.size() * sizeof(GpkEntry));
+    memcpy(file.start + header.paths_offset, paths.data(), paths.size());
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        const uint8_t *data = entries[i].compression == GPK_LZ4 ? compressed[i].data() : inputs[i].data;
+        memcpy(file.start + entries[i].offset, data, entries[i].size);
+    }
+
+    if (!unmap_and_close_file(file))
+    {
+        remove(temp_path.c_str());
+        return false;
+    }
+
+    remove(path);
+    return rename(temp_path.c_str(), path) == 0;
+}
+
+bool pack_mount(const char *path)
+{
+    pack_unmount();
+    if (!file_exists(path))
+        return false;
+
+    File file = open_or_create_file(path, IO_READ_ONLY, 0);
+    if (file.handle == IO_BAD_FILE_HANDLE)
+        return false;
+    if (file.size < sizeof(GpkHeader) || !map_file(&file))
+    {
+        close_file(file);
+        return false;
+    }
+
+    const GpkHeader *header = (const GpkHeader *)file.start;
+    bool valid = header->magic == GPK_MAGIC && header->version == GPK_VERSION &&
+                 header->slot_count && (header->slot_count & (header->slot_count - 1)) == 0 &&
+                 header->entry_count <= header->slot_count &&
+                 header->slots_offset <= file.size &&
+                 (uint64_t)header->slot_count * sizeof(uint32_t) <= file.size - header->slots_offset &&
+                 header->entries_offset <= file.size &&
+                 (uint64_t)header->entry_count * sizeof(GpkEntry) <= file.size - header->entries_offset &&
+                 header->paths_offset <= file.size;
+
+    const uint32_t *slots = (const uint32_t *)(file.start + header->slots_offset);
+    const GpkEntry *entries = (const GpkEntry *)(file.start + header->entries_offset);
+    for (uint32_t i = 0; valid && i < header->slot_count; i++)
+        valid = slots[i] == GPK_EMPTY || slots[i] < header->entry_count;
+    for (uint32_t i = 0; valid && i < header->entry_count; i++)
+    {
+        const GpkEntry &entry = entries[i];
+        valid = entry.offset <= file.size && entry.size <= file.size - entry.offset &&
+                (uint64_t)entry.path_offset + entry.path_size <= file.size - header->paths_offset &&
+                (entry.compression == GPK_STORED ? entry.size == entry.raw_size : entry.compression == GPK_LZ4);
+    }
+
+    if (!valid)
+    {
+        printf("Invalid asset pack %s\n", path);
+        unmap_and_close_file(file);
+        return false;
+    }
+
+    printf("Mounted asset pack %s: %u entries\n", path, header->entry_count);
+    pack_file = file;
+    pack = header;
+    return true;
+}
+
+void pack_unmount()
+{
+    if (!pack)
+        return;
+    inflated.clear();
+    unmap_and_close_file(pack_file);
+    memset(&pack_file, 0, sizeof(File));
+    pack = NULL;
+}
+
+static bool find_in_pack(const char *path, AssetSpan &span)
+{
+    size_t path_size = strlen(path);
+    uint64_t hash = path_hash(path, path_size);
+    const uint32_t *slots = (const uint32_t *)(pack_file.start + pack->slots_offset);
+    const GpkEntry *entries = (const GpkEntry *)(pack_file.start + pack->entries_offset);
+    const char *paths = (const char *)pack_file.start + pack->paths_offset;
+
+    uint32_t mask = pack->slot_count - 1;
+    for (uint32_t slot = (uint32_t)hash & mask; slots[slot] != GPK_EMPTY; slot = (slot + 1) & mask)
+    {
+        uint32_t index = slots[slot];
+        const GpkEntry &entry = entries[index];
+        if (entry.hash != hash || entry.path_size != path_size || memcmp(paths + entry.path_offset, path, path_size) != 0)
+            continue;
+
+        const uint8_t *data = pack_file.start + entry.offset;
+        if (entry.compression == GPK_STORED)
+        {
+            span = {data, (size_t)entry.size};
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(inflated_mutex);
+        auto found = inflated.find(index);
+        if (found == inflated.end())
+        {
+            std::vector<uint8_t> raw(entry.raw_size);
+            if (!lz4_decompress(data, entry.size, raw.data(), raw.size()))
+            {
+                printf("Corrupt asset %s in pack\n", path);
+                return false;
+            }
+            found = inflated.emplace(index, std::move(raw)).first;
+        }
+        span = {found->second.data(), found->second.size()};
+        return true;
+    }
+    return false;
+}
+
+bool find_packed(const char *path, AssetSpan &span)
+{
+    if (pack && find_in_pack(path, span))
+        return true;
+    if (EmbeddedFile const *embedded = find_embedded(path))
+    {
+        span = {embedded->data, embedded->size};
+        return true;
+    }
+    return false;
+}
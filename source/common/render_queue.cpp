@@ -0,0 +1,165 @@
+#include <string.h>
+
+#include <algorithm>
+
+#include "instancing.hpp"
+#include "render_queue.hpp"
+
+static inline uint64_t key_bits(uint64_t value, int bits, int shift)
+{
+    return (value & ((1ull << bits) - 1)) << shift;
+}
+
+static bool same_run(RenderItem const &a, RenderItem const &b)
+{
+    Model const *x = a.model;
+    Model const *y = b.model;
+    GLuint x_array = x->texture ? x->texture->array->id : 0;
+    GLuint y_array = y->texture ? y->texture->array->id : 0;
+    return a.key >> 62 == b.key >> 62 && x->program == y->program && x->mesh == y->mesh &&
+           x_array == y_array && a.lod == b.lod;
+}
+
+void RenderQueue::clear()
+{
+    items.clear();
+    uploaded = false;
+}
+
+void RenderQueue::push(Model *model, glm::mat4 const &view_projection, bool overlay)
+{
+    Mesh const *mesh = model->mesh.get();
+    uint32_t lod = (uint32_t)(&model->select_lod(view_projection) - mesh->lods.data());
+    GLuint array = model->texture ? model->texture->array->id : 0;
+
+    uint64_t key;
+    if (!overlay && model->color.a < 1.0f)
+    {
+        // w is the distance along the view direction, positive floats sort as their bits
+        glm::vec3 center = (model->box.min + model->box.max) * 0.5f;
+        float depth = std::max((view_projection * glm::vec4(center, 1.0f)).w, 0.0f);
+        uint32_t depth_bits;
+        memcpy(&depth_bits, &depth, sizeof(depth_bits));
+        key = key_bits(RENDER_TRANSPARENT, 2, 62) | key_bits(~depth_bits, 32, 30) |
+              key_bits(model->program->index, 10, 20) | key_bits(mesh->id, 20, 0);
+    }
+    else
+    {
+        key = key_bits(overlay ? RENDER_OVERLAY : RENDER_OPAQUE, 2, 62) | key_bits(model->program->index, 10, 52) |
+              key_bits(array, 12, 40) | key_bits(mesh->id, 20, 20) | key_bits(lod, 4, 16);
+    }
+    items.push_back({key, model, lod});
+}
+
+// LSD radix sort a byte at a time, stable so equal keys keep push order
+void RenderQueue::sort()
+{
+    size_t count = items.size();
+    uploaded = false;
+    if (count < 2)
+        return;
+    scratch.resize(count);
+    RenderItem *src = items.data();
+    RenderItem *dst = scratch.data();
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t offsets[256] = {};
+        for (size_t i = 0; i < count; i++)
+            offsets[(src[i].key >> shift) & 0xFF]++;
+        // a byte every key shares would only copy
+        if (offsets[(src[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        size_t offset = 0;
+        for (size_t &bucket : offsets)
+        {
+            size_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (size_t i = 0; i < count; i++)
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+        std::swap(src, dst);
+    }
+    if (src != items.data())
+        items.swap(scratch);
+}
+
+void RenderQueue::execute(RenderLayer first_layer, RenderLayer last_layer)
+{
+    // sorted, so each layer is one range
+    size_t begin = 0;
+    while (begin < items.size() && items[begin].key >> 62 < (uint64_t)first_layer)
+        begin++;
+    size_t count = begin;
+    while (count < items.size() && items[count].key >> 62 <= (uint64_t)last_layer)
+        count++;
+    if (begin == count)
+        return;
+
+    if (!uploaded)
+    {
+        instances = frame_alloc(items.size() * sizeof(InstanceData));
+        InstanceData *data = (InstanceData *)instances.data;
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            Model const *model = items[i].model;
+            InstanceData &instance = data[i];
+            instance.matrix = model->matrix * model->mesh->dequantize;
+            instance.color = model->color;
+            instance.layer = model->texture ? (float)model->texture->layer : 0.0f;
+        }
+        frame_flush(instances);
+        uploaded = true;
+    }
+
+    uint64_t layer = UINT64_MAX; // none yet
+    Program *bound_program = NULL;
+    GLuint bound_array = 0;
+    GLuint bound_vertex_array = 0;
+    for (size_t first = begin, last; first < count; first = last)
+    {
+        last = first + 1;
+        while (last < count && same_run(items[first], items[last]))
+            last++;
+
+        RenderItem const &item = items[first];
+        Model const *model = item.model;
+        if (item.key >> 62 != layer)
+        {
+            layer = item.key >> 62;
+            glDepthMask(layer == RENDER_TRANSPARENT ? GL_FALSE : GL_TRUE);
+            if (layer == RENDER_OVERLAY)
+                glClear(GL_DEPTH_BUFFER_BIT);
+        }
+
+        if (model->program != bound_program)
+        {
+            use_program(*model->program);
+            bound_program = model->program;
+        }
+        GLuint array = model->texture ? model->texture->array->id : 0;
+        if (array && array != bound_array)
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+            bound_array = array;
+        }
+
+        Mesh const *mesh = model->mesh.get();
+        if (mesh->vertex_array != bound_vertex_array)
+        {
+            glBindVertexArray(mesh->vertex_array);
+            bound_vertex_array = mesh->vertex_array;
+        }
+        // the instance attributes live in the vertex array, pointed at this run's offset
+        MeshLod const &lod = mesh->lods[item.lod];
+        size_t index_size = mesh->index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        bind_instances(instances.buffer, instances.offset + first * sizeof(InstanceData));
+        glDrawElementsInstanced(GL_TRIANGLES, lod.index_count, mesh->index_type, (void *)(lod.index_offset * index_size), (GLsizei)(last - first));
+    }
+    if (layer == RENDER_TRANSPARENT)
+        glDepthMask(GL_TRUE);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
@@ -1,4 +1,11 @@
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gom.hpp"
 #include "io.hpp"
+#include "pack.hpp"
 #include "shader.hpp"
 
 #define PANIC(fmt, ...)                                        \
@@ -8,12 +15,64 @@
         exit(1);                                               \
     } while (0)
 
-void compile_shader(GLuint shader_id, void *shader_source)
+// .gpb holds one linked program as returned by glGetProgramBinary, only
+// valid for the driver and sources it was built from
+#define GPB_MAGIC 0x31425047 // "GPB1"
+#define GPB_VERSION 1
+// every .gpb goes here, named after the program key and the driver
+#define GPB_DIRECTORY "shader_cache"
+
+struct GpbHeader
 {
-    GLint compiled = false;
+    uint32_t magic;
+    uint32_t version;
+    uint64_t driver_hash;
+    uint64_t source_hash;
+    uint32_t binary_format;
+    uint32_t binary_size;
+};
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif // GL_COMPLETION_STATUS_KHR
+
+// keyed by vertex path, fragment path and defines, the Program pointers
+// handed out stay valid as it grows
+static std::unordered_map<std::string, Program> programs;
+// requested but not yet finished
+static std::vector<Program *> pending;
+static bool parallel_compile = false;
+
+static uint64_t hash_combine(uint64_t h, const void *data, size_t size)
+{
+    return (h ^ gom_hash((const uint8_t *)data, size)) * 0x100000001B3ull;
+}
+
+static void submit_shader(GLuint shader_id, const char *source, size_t size, const char *defines)
+{
+    // defines have to follow the #version line
+    const GLchar *strings[3];
+    GLint lengths[3];
+    size_t version = 0;
+    if (size > 8 && memcmp(source, "#version", 8) == 0)
+    {
+        const char *newline = (const char *)memchr(source, '\n', size);
+        version = newline ? newline - source + 1 : size;
+    }
+    strings[0] = source;
+    lengths[0] = (GLint)version;
+    strings[1] = defines;
+    lengths[1] = (GLint)strlen(defines);
+    strings[2] = source + version;
+    lengths[2] = (GLint)(size - version);
 
-    glShaderSource(shader_id, 1, (const GLchar *const *)&shader_source, nullptr);
+    glShaderSource(shader_id, 3, strings, lengths);
     glCompileShader(shader_id);
+}
+
+static void check_shader(GLuint shader_id)
+{
+    GLint compiled = false;
     glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compiled);
 
     if (compiled != GL_TRUE)
@@ -25,47 +84,300 @@ void compile_shader(GLuint shader_id, void *shader_source)
     }
 }
 
-GLuint load_shaders(const char *vertex_path, const char *fragment_path)
+void compile_shader(GLuint shader_id, const char *source, size_t size, const char *defines)
+{
+    submit_shader(shader_id, source, size, defines);
+    check_shader(shader_id);
+}
+
+// A shader source, packed, embedded or mapped from its file
+struct ShaderSource
+{
+    File file;
+    const char *data;
+    size_t size;
+};
+
+static ShaderSource open_shader(const char *path)
+{
+    ShaderSource source = {};
+    AssetSpan packed;
+    if (find_packed(path, packed))
+    {
+        source.data = (const char *)packed.data;
+        source.size = packed.size;
+        return source;
+    }
+    source.file = open_and_map_file(path, IO_READ_ONLY);
+    source.data = (const char *)source.file.start;
+    source.size = source.file.size;
+    return source;
+}
+
+static void close_shader(ShaderSource &source)
+{
+    if (source.file.start)
+        UNMAP_AND_CLOSE_FILE(source.file);
+}
+
+// Queues compile and link, nothing waits for the driver until finish_program
+static void submit_program(Program &program, ShaderSource const &vertex, ShaderSource const &fragment, const char *defines, bool retrievable)
 {
-    GLuint vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
+    program.vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    program.fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    submit_shader(program.vertex_shader, vertex.data, vertex.size, defines);
+    submit_shader(program.fragment_shader, fragment.data, fragment.size, defines);
 
-#if 0
-compile_shader(vertex_shader_id, VERTEX_SHADER_SOURCE);
-compile_shader(fragment_shader_id, FRAGMENT_SHADER_SOURCE);
+    program.id = glCreateProgram();
+    glAttachShader(program.id, program.vertex_shader);
+    glAttachShader(program.id, program.fragment_shader);
+#ifndef __EMSCRIPTEN__
+    if (retrievable)
+        glProgramParameteri(program.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 #else
-    auto vertex_shader_file =
-        open_and_map_file(vertex_path, IO_READ_ONLY);
-    compile_shader(vertex_shader_id, vertex_shader_file.start);
-    UNMAP_AND_CLOSE_FILE(vertex_shader_file);
-
-    auto fragment_shader_file =
-        open_and_map_file(fragment_path, IO_READ_ONLY);
-    compile_shader(fragment_shader_id, fragment_shader_file.start);
-    UNMAP_AND_CLOSE_FILE(fragment_shader_file);
-#endif // NDEBUG
-
-    GLuint program_id = glCreateProgram();
-    glAttachShader(program_id, vertex_shader_id);
-    glAttachShader(program_id, fragment_shader_id);
-    glLinkProgram(program_id);
-
-    GLint linked = 0;
-    glGetProgramiv(program_id, GL_LINK_STATUS, &linked);
-
-    if (linked != GL_TRUE)
+    (void)retrievable;
+#endif // __EMSCRIPTEN__
+    glLinkProgram(program.id);
+}
+
+#ifndef __EMSCRIPTEN__
+static bool program_binaries_supported()
+{
+    static int supported = -1;
+    if (supported < 0)
     {
-        GLchar buffer[1024] = {0};
-        GLsizei length = 0;
-        glGetProgramInfoLog(program_id, sizeof(buffer), &length, buffer);
-        PANIC("Could not compile shader: %s", buffer);
+        GLint formats = 0;
+        if (GLEW_ARB_get_program_binary || GLEW_VERSION_4_1)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        supported = formats > 0;
+    }
+    return supported;
+}
+
+static uint64_t driver_hash()
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+    GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (GLenum name : names)
+    {
+        const char *value = (const char *)glGetString(name);
+        if (value)
+            h = hash_combine(h, value, strlen(value));
     }
+    return h;
+}
 
-    glDetachShader(program_id, vertex_shader_id);
-    glDetachShader(program_id, fragment_shader_id);
+// 0 when the cache is missing, stale or refused by the driver
+static GLuint load_program_binary(const char *path, uint64_t driver, uint64_t source)
+{
+    if (!file_exists(path))
+        return 0;
+    File file = open_or_create_file(path, IO_READ_ONLY, 0);
+    if (file.handle == IO_BAD_FILE_HANDLE)
+        return 0;
+    if (!map_file(&file))
+    {
+        close_file(file);
+        return 0;
+    }
 
-    glDeleteShader(vertex_shader_id);
-    glDeleteShader(fragment_shader_id);
+    GLuint program_id = 0;
+    GpbHeader const *header = (GpbHeader const *)file.start;
+    if (file.size >= sizeof(GpbHeader) && header->magic == GPB_MAGIC && header->version == GPB_VERSION &&
+        header->driver_hash == driver && header->source_hash == source &&
+        file.size >= sizeof(GpbHeader) + header->binary_size)
+    {
+        program_id = glCreateProgram();
+        glProgramBinary(program_id, header->binary_format, file.start + sizeof(GpbHeader), header->binary_size);
 
+        // drivers may still reject a binary after an update that kept the version string
+        GLint linked = 0;
+        glGetProgramiv(program_id, GL_LINK_STATUS, &linked);
+        if (linked != GL_TRUE)
+        {
+            glDeleteProgram(program_id);
+            program_id = 0;
+        }
+    }
+    unmap_and_close_file(file);
     return program_id;
 }
+
+static void save_program_binary(const char *path, GLuint program_id, uint64_t driver, uint64_t source)
+{
+    GLint length = 0;
+    glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    // write to a temporary and rename so a crash never leaves a torn cache
+    std::string temp_path = std::string(path) + ".tmp";
+    File file = open_or_create_file(temp_path.c_str(), IO_READ_WRITE, 1);
+    if (file.handle == IO_BAD_FILE_HANDLE)
+        return;
+    if (!truncate_file(&file, sizeof(GpbHeader) + length) || !map_file(&file))
+    {
+        close_file(file);
+        remove(temp_path.c_str());
+        return;
+    }
+
+    GpbHeader header;
+    memset(&header, 0, sizeof(GpbHeader));
+    header.magic = GPB_MAGIC;
+    header.version = GPB_VERSION;
+    header.driver_hash = driver;
+    header.source_hash = source;
+
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program_id, length, &written, &format, file.start + sizeof(GpbHeader));
+    header.binary_format = format;
+    header.binary_size = (uint32_t)written;
+    memcpy(file.start, &header, sizeof(GpbHeader));
+
+    if (!unmap_and_close_file(file) || written <= 0)
+    {
+        remove(temp_path.c_str());
+        return;
+    }
+    remove(path);
+    rename(temp_path.c_str(), path);
+}
+#endif // __EMSCRIPTEN__
+
+Program *request_program(const char *vertex_path, const char *fragment_path, const char *defines)
+{
+    std::string key = std::string(vertex_path) + '\n' + fragment_path + '\n' + defines;
+    auto found = programs.find(key);
+    if (found != programs.end())
+        return &found->second;
+
+    static bool started = false;
+    if (!started)
+    {
+        started = true;
+#ifndef __EMSCRIPTEN__
+        // let the driver pick how many threads
+        if (GLEW_KHR_parallel_shader_compile)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        else if (GLEW_ARB_parallel_shader_compile)
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        parallel_compile = GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+#endif // __EMSCRIPTEN__
+    }
+
+    Program &program = programs[key];
+    program.index = (uint32_t)programs.size() - 1;
+    program.vertex_path = vertex_path;
+    program.fragment_path = fragment_path;
+    program.defines = defines;
+    ShaderSource vertex = open_shader(vertex_path);
+    ShaderSource fragment = open_shader(fragment_path);
+
+#ifndef __EMSCRIPTEN__
+    bool binaries = program_binaries_supported();
+    if (binaries)
+    {
+        program.driver_hash = driver_hash();
+        uint64_t source = hash_combine(0xCBF29CE484222325ull, vertex.data, vertex.size);
+        source = hash_combine(source, fragment.data, fragment.size);
+        program.source_hash = hash_combine(source, defines, strlen(defines));
+
+        static bool have_directory = create_directory(GPB_DIRECTORY);
+        if (have_directory)
+        {
+            char name[64];
+            snprintf(name, sizeof(name), "/%016llx.%016llx.gpb",
+                     (unsigned long long)hash_combine(0, key.data(), key.size()), (unsigned long long)program.driver_hash);
+            program.cache_path = GPB_DIRECTORY + std::string(name);
+            program.id = load_program_binary(program.cache_path.c_str(), program.driver_hash, program.source_hash);
+        }
+    }
+    if (!program.id)
+        submit_program(program, vertex, fragment, defines, binaries);
+#else
+    submit_program(program, vertex, fragment, defines, false);
+#endif // __EMSCRIPTEN__
+
+    close_shader(vertex);
+    close_shader(fragment);
+
+    pending.push_back(&program);
+    return &program;
+}
+
+void finish_program(Program &program)
+{
+    if (program.finished)
+        return;
+
+    if (program.vertex_shader)
+    {
+        check_shader(program.vertex_shader);
+        check_shader(program.fragment_shader);
+
+        GLint linked = 0;
+        glGetProgramiv(program.id, GL_LINK_STATUS, &linked);
+
+        if (linked != GL_TRUE)
+        {
+            GLchar buffer[1024] = {0};
+            GLsizei length = 0;
+            glGetProgramInfoLog(program.id, sizeof(buffer), &length, buffer);
+            PANIC("Could not compile shader: %s", buffer);
+        }
+
+        glDetachShader(program.id, program.vertex_shader);
+        glDetachShader(program.id, program.fragment_shader);
+
+        glDeleteShader(program.vertex_shader);
+        glDeleteShader(program.fragment_shader);
+        program.vertex_shader = 0;
+        program.fragment_shader = 0;
+
+#ifndef __EMSCRIPTEN__
+        if (!program.cache_path.empty())
+            save_program_binary(program.cache_path.c_str(), program.id, program.driver_hash, program.source_hash);
+#endif // __EMSCRIPTEN__
+    }
+
+    GLuint frame_block = glGetUniformBlockIndex(program.id, "Frame");
+    if (frame_block != GL_INVALID_INDEX)
+        glUniformBlockBinding(program.id, frame_block, FRAME_BLOCK_BINDING);
+    GLuint object_block = glGetUniformBlockIndex(program.id, "Object");
+    if (object_block != GL_INVALID_INDEX)
+        glUniformBlockBinding(program.id, object_block, OBJECT_BLOCK_BINDING);
+    program.finished = true;
+    pending.erase(std::find(pending.begin(), pending.end(), &program));
+}
+
+void poll_programs()
+{
+    if (!parallel_compile)
+        return;
+
+    std::vector<Program *> done;
+    for (Program *program : pending)
+    {
+        GLint complete = GL_FALSE;
+        glGetProgramiv(program->id, GL_COMPLETION_STATUS_KHR, &complete);
+        if (complete)
+            done.push_back(program);
+    }
+    for (Program *program : done)
+        finish_program(*program);
+}
+
+void use_program(Program &program)
+{
+    finish_program(program);
+    glUseProgram(program.id);
+}
+
+GLuint load_shaders(const char *vertex_path, const char *fragment_path, const char *defines)
+{
+    Program *program = request_program(vertex_path, fragment_path, defines);
+    finish_program(*program);
+    return program->id;
+}
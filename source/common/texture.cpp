@@ -0,0 +1,381 @@
+#include <string.h>
+
+#include <unordered_map>
+
+#define STB_IMAGE_IMPLEMENTATION
+// images are decoded on the asset workers, keep stbi_failure_reason per thread
+#define STBI_THREAD_LOCAL thread_local
+#include "stb_image.h"
+
+#include "assets.hpp"
+#include "gtx.hpp"
+#include "pack.hpp"
+#include "texture.hpp"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif // GL_COMPRESSED_RGB8_ETC2
+
+static std::unordered_map<std::string, std::weak_ptr<Texture>> registry;
+// every array with room left or in use, looked up by shape on upload
+static std::vector<std::weak_ptr<TextureArray>> arrays;
+
+static GLenum internal_format(TextureFormat format)
+{
+    if (format == TEXTURE_BC1)
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    if (format == TEXTURE_ETC2)
+        return GL_COMPRESSED_RGB8_ETC2;
+    return GL_RGB8;
+}
+
+TextureArray::TextureArray(TextureFormat format, uint32_t width, uint32_t height, uint32_t levels, uint32_t layers)
+    : format(format), width(width), height(height), levels(levels), used(layers, 0)
+{
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+    for (uint32_t level = 0; level < levels; level++)
+    {
+        uint32_t w = width >> level ? width >> level : 1;
+        uint32_t h = height >> level ? height >> level : 1;
+        if (format == TEXTURE_RGB8)
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGB8, w, h, layers, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        else
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internal_format(format), w, h, layers, 0,
+                                   (GLsizei)(texture_level_size(format, w, h) * layers), NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, levels > 1 ? GL_LINEAR : GL_NEAREST);
+}
+
+TextureArray::~TextureArray()
+{
+    glDeleteTextures(1, &id);
+}
+
+int TextureArray::allocate()
+{
+    for (size_t i = 0; i < used.size(); i++)
+    {
+        if (!used[i])
+        {
+            used[i] = 1;
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void TextureArray::release(uint32_t layer)
+{
+    used[layer] = 0;
+}
+
+// A layer in an array of this shape, starting a new array when all are full
+static std::shared_ptr<TextureArray> allocate_layer(TextureFormat format, uint32_t width, uint32_t height, uint32_t levels, uint32_t &layer)
+{
+    for (size_t i = 0; i < arrays.size();)
+    {
+        auto array = arrays[i].lock();
+        if (!array)
+        {
+            arrays.erase(arrays.begin() + i);
+            continue;
+        }
+        if (array->format == format && array->width == width && array->height == height && array->levels == levels)
+        {
+            int free_layer = array->allocate();
+            if (free_layer >= 0)
+            {
+                layer = free_layer;
+                return array;
+            }
+        }
+        i++;
+    }
+
+    auto array = std::make_shared<TextureArray>(format, width, height, levels, TEXTURE_ARRAY_LAYERS);
+    arrays.push_back(array);
+    layer = array->allocate();
+    return array;
+}
+
+Texture::Texture()
+{
+    // one white texel shared by everything still loading
+    static std::weak_ptr<TextureArray> placeholder;
+    array = placeholder.lock();
+    if (!array)
+    {
+        static const unsigned char white[3] = {255, 255, 255};
+        array = std::make_shared<TextureArray>(TEXTURE_RGB8, 1, 1, 1, 1);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, 1, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, white);
+        placeholder = array;
+    }
+}
+
+Texture::~Texture()
+{
+    if (!path.empty())
+    {
+        auto it = registry.find(path);
+        if (it != registry.end() && it->second.expired())
+            registry.erase(it);
+    }
+    if (loaded)
+        array->release(layer);
+}
+
+static bool has_extension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char *extension = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// ETC2 is core in ES3 but an extension in WebGL, S3TC is everywhere on desktop
+uint32_t texture_formats()
+{
+    static uint32_t formats = 0;
+    if (!formats)
+    {
+        formats = 1 << TEXTURE_RGB8;
+        // full names, WEBGL_compressed_texture_etc1 has no ETC2
+        if (has_extension("GL_EXT_texture_compression_s3tc") || has_extension("WEBGL_compressed_texture_s3tc"))
+            formats |= 1 << TEXTURE_BC1;
+        if (has_extension("WEBGL_compressed_texture_etc") || has_extension("GL_ARB_ES3_compatibility"))
+            formats |= 1 << TEXTURE_ETC2;
+    }
+    return formats;
+}
+
+TextureFormat texture_format()
+{
+    uint32_t formats = texture_formats();
+#ifdef __EMSCRIPTEN__
+    TextureFormat order[] = {TEXTURE_ETC2, TEXTURE_BC1};
+#else
+    TextureFormat order[] = {TEXTURE_BC1, TEXTURE_ETC2};
+#endif // __EMSCRIPTEN__
+    for (TextureFormat format : order)
+    {
+        if (formats & (1 << format))
+            return format;
+    }
+    return TEXTURE_RGB8;
+}
+
+// Mip levels sent one per step into a free layer, from the mapped cache
+// when there is one. Uncompressed levels go a few rows at a time. The
+// texture moves to its layer once every level is there.
+struct TextureUpload
+{
+    std::weak_ptr<Texture> texture;
+    TextureFormat format;
+    uint32_t formats; // texture_formats(), for packed caches in another format
+    GtxTexture gtx = {};
+    std::vector<TextureLevel> levels;
+    std::shared_ptr<TextureArray> array;
+    uint32_t layer = 0;
+    uint32_t level = 0;
+    uint32_t row = 0;
+
+    ~TextureUpload()
+    {
+        gtx_close(gtx);
+        if (array)
+            array->release(layer);
+    }
+
+    uint32_t level_count() const
+    {
+        return gtx.header ? gtx.header->level_count : (uint32_t)levels.size();
+    }
+
+    void level_info(uint32_t i, uint32_t &width, uint32_t &height, const uint8_t *&data) const
+    {
+        if (gtx.header)
+        {
+            width = gtx.header->levels[i].width;
+            height = gtx.header->levels[i].height;
+            data = gtx_level_data(gtx, i);
+        }
+        else
+        {
+            width = levels[i].width;
+            height = levels[i].height;
+            data = levels[i].pixels.data();
+        }
+    }
+
+    AssetStep step()
+    {
+        auto target = texture.lock();
+        if (!target || level_count() == 0)
+            return ASSET_STEP_DONE;
+
+        uint32_t width, height;
+        const uint8_t *data;
+        level_info(level, width, height, data);
+
+        // a band of whole pixel rows, or of 4-row block rows when compressed
+        uint32_t band = format == TEXTURE_RGB8 ? 1 : 4;
+        size_t band_size = format == TEXTURE_RGB8 ? (size_t)width * 3 : texture_level_size(format, width, 4);
+        uint32_t rows = (uint32_t)(ASSET_UPLOAD_CHUNK / band_size) * band;
+        if (rows < band)
+            rows = band;
+        if (rows > height - row)
+            rows = height - row;
+        size_t offset = (size_t)(row / band) * band_size;
+        size_t size = (size_t)((rows + band - 1) / band) * band_size;
+
+        if (!staging_begin(data + offset, size))
+            return ASSET_STEP_WAIT;
+
+        if (!array)
+        {
+            uint32_t count = level_count();
+            array = allocate_layer(format, width, height, count, layer);
+        }
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array->id);
+        if (format == TEXTURE_RGB8)
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, row, layer, width, rows, 1, GL_RGB, GL_UNSIGNED_BYTE, (const void *)0);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+        else
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, row, layer, width, rows, 1, internal_format(format),
+                                      (GLsizei)size, (const void *)0);
+        staging_end();
+
+        row += rows;
+        if (row < height)
+            return ASSET_STEP_MORE;
+
+        row = 0;
+        if (++level < level_count())
+            return ASSET_STEP_MORE;
+
+        level_info(0, width, height, data);
+        target->array = array;
+        target->layer = layer;
+        target->width = width;
+        target->height = height;
+        target->loaded = true;
+        array.reset();
+        return ASSET_STEP_DONE;
+    }
+};
+
+// Decodes and builds the cache, or just maps the cache when it is current
+static void read_texture(const char *path, TextureUpload &upload)
+{
+    // the build may have packed a format this context wasn't the first choice for
+    AssetSpan packed;
+    TextureFormat order[] = {upload.format, TEXTURE_BC1, TEXTURE_ETC2, TEXTURE_RGB8};
+    for (TextureFormat format : order)
+    {
+        if (!(upload.formats & (1 << format)))
+            continue;
+        if (find_packed(gtx_cache_path(path, format).c_str(), packed) && gtx_parse(packed.data, packed.size, format, upload.gtx))
+        {
+            upload.format = format;
+            return;
+        }
+    }
+
+    std::string cache_path = gtx_cache_path(path, upload.format);
+
+    GomSource source;
+    bool have_source = gom_source_info(path, source);
+
+    if (have_source && gtx_open(cache_path.c_str(), path, source, upload.format, upload.gtx))
+    {
+        printf("Loading texture cache %s...\n", cache_path.c_str());
+        return;
+    }
+
+    // a packed build without the file on disk may still have the image
+    int width, height, channels;
+    stbi_uc *pixels;
+    if (!have_source && find_packed(path, packed))
+        pixels = stbi_load_from_memory(packed.data, (int)packed.size, &width, &height, &channels, 3);
+    else
+        pixels = stbi_load(path, &width, &height, &channels, 3);
+    if (!pixels)
+    {
+        printf("Could not load texture %s: %s\n", path, stbi_failure_reason());
+        return;
+    }
+    build_mips(pixels, width, height, upload.levels);
+    stbi_image_free(pixels);
+
+    if (have_source)
+    {
+        File file = open_or_create_file(path, IO_READ_ONLY, 0);
+        if (file.handle != IO_BAD_FILE_HANDLE && map_file(&file))
+        {
+            source.hash = gom_hash(file.start, file.size);
+            unmap_and_close_file(file);
+        }
+        else if (file.handle != IO_BAD_FILE_HANDLE)
+            close_file(file);
+
+        printf("Building texture cache %s...\n", cache_path.c_str());
+        if (gtx_write(cache_path.c_str(), source, upload.format, upload.levels) &&
+            gtx_open(cache_path.c_str(), path, source, upload.format, upload.gtx))
+        {
+            upload.levels.clear();
+            return;
+        }
+        printf("Could not write texture cache %s\n", cache_path.c_str());
+    }
+
+    // no cache to map, encode in memory
+    if (upload.format != TEXTURE_RGB8)
+    {
+        for (auto &level : upload.levels)
+        {
+            std::vector<uint8_t> encoded(texture_level_size(upload.format, level.width, level.height));
+            encode_texture(upload.format, level.pixels.data(), level.width, level.height, encoded.data());
+            level.pixels.swap(encoded);
+        }
+    }
+}
+
+std::shared_ptr<Texture> load_texture(const char *path)
+{
+    auto &entry = registry[path];
+    if (auto texture = entry.lock())
+        return texture;
+
+    auto texture = std::make_shared<Texture>();
+    texture->path = path;
+    entry = texture;
+
+    std::weak_ptr<Texture> weak = texture;
+    std::string source = path;
+    TextureFormat format = texture_format();
+    uint32_t formats = texture_formats();
+    queue_asset([weak, source, format, formats]() -> AssetUpload
+                {
+                    auto upload = std::make_shared<TextureUpload>();
+                    upload->texture = weak;
+                    upload->format = format;
+                    upload->formats = formats;
+                    read_texture(source.c_str(), *upload);
+                    return [upload]() { return upload->step(); }; });
+    return texture;
+}
@@ -0,0 +1,519 @@
+#include <math.h>
+#include <string.h>
+
+#include <array>
+
+#include "texture_codec.hpp"
+
+// Built once by whichever asset worker gets here first, the others wait
+static std::array<float, 256> const &srgb_table()
+{
+    static std::array<float, 256> const table = [] {
+        std::array<float, 256> values;
+        for (int i = 0; i < 256; i++)
+        {
+            float v = i / 255.0f;
+            values[i] = v <= 0.04045f ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table;
+}
+
+static inline uint8_t linear_to_srgb(float v)
+{
+    v = v <= 0.0031308f ? v * 12.92f : 1.055f * powf(v, 1.0f / 2.4f) - 0.055f;
+    int c = (int)(v * 255.0f + 0.5f);
+    return (uint8_t)(c < 0 ? 0 : c > 255 ? 255 : c);
+}
+
+void build_mips(const uint8_t *rgb, uint32_t width, uint32_t height, std::vector<TextureLevel> &levels)
+{
+    std::array<float, 256> const &srgb_to_linear = srgb_table();
+
+    levels.clear();
+    levels.push_back(TextureLevel{width, height, std::vector<uint8_t>(rgb, rgb + (size_t)width * height * 3)});
+
+    while (width > 1 || height > 1)
+    {
+        const TextureLevel &src = levels.back();
+        uint32_t w = width > 1 ? width / 2 : 1;
+        uint32_t h = height > 1 ? height / 2 : 1;
+        TextureLevel level = {w, h, std::vector<uint8_t>((size_t)w * h * 3)};
+
+        for (uint32_t y = 0; y < h; y++)
+        {
+            // odd sizes fold the last row or column into the final texel
+            uint32_t y0 = height > 1 ? y * 2 : 0, y1 = height > 1 ? y * 2 + 1 : 0;
+            for (uint32_t x = 0; x < w; x++)
+            {
+                uint32_t x0 = width > 1 ? x * 2 : 0, x1 = width > 1 ? x * 2 + 1 : 0;
+                for (int c = 0; c < 3; c++)
+                {
+                    float sum = srgb_to_linear[src.pixels[((size_t)y0 * width + x0) * 3 + c]] +
+                                srgb_to_linear[src.pixels[((size_t)y0 * width + x1) * 3 + c]] +
+                                srgb_to_linear[src.pixels[((size_t)y1 * width + x0) * 3 + c]] +
+                                srgb_to_linear[src.pixels[((size_t)y1 * width + x1) * 3 + c]];
+                    level.pixels[((size_t)y * w + x) * 3 + c] = linear_to_srgb(sum * 0.25f);
+                }
+            }
+        }
+
+        width = w;
+        height = h;
+        levels.push_back(std::move(level));
+    }
+}
+
+size_t texture_level_size(TextureFormat format, uint32_t width, uint32_t height)
+{
+    if (format == TEXTURE_RGB8)
+        return (size_t)width * height * 3;
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+static void fetch_block(const uint8_t *rgb, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, int block[16][3])
+{
+    for (int y = 0; y < 4; y++)
+    {
+        uint32_t sy = by * 4 + y < height ? by * 4 + y : height - 1;
+        for (int x = 0; x < 4; x++)
+        {
+            uint32_t sx = bx * 4 + x < width ? bx * 4 + x : width - 1;
+            const uint8_t *p = rgb + ((size_t)sy * width + sx) * 3;
+            block[y * 4 + x][0] = p[0];
+            block[y * 4 + x][1] = p[1];
+            block[y * 4 + x][2] = p[2];
+        }
+    }
+}
+
+static void store_block(uint8_t *rgb, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, int block[16][3])
+{
+    for (int y = 0; y < 4 && by * 4 + y < height; y++)
+    {
+        for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+        {
+            uint8_t *p = rgb + ((size_t)(by * 4 + y) * width + bx * 4 + x) * 3;
+            p[0] = (uint8_t)block[y * 4 + x][0];
+            p[1] = (uint8_t)block[y * 4 + x][1];
+            p[2] = (uint8_t)block[y * 4 + x][2];
+        }
+    }
+}
+
+static inline int clamp255(int v)
+{
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static inline int color_error(const int a[3], const int b[3])
+{
+    int r = a[0] - b[0], g = a[1] - b[1], bl = a[2] - b[2];
+    return r * r + g * g + bl * bl;
+}
+
+// BC1
+
+static inline uint16_t pack_565(const float c[3])
+{
+    int r = (int)(c[0] * 31.0f / 255.0f + 0.5f), g = (int)(c[1] * 63.0f / 255.0f + 0.5f), b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+    r = r < 0 ? 0 : r > 31 ? 31 : r;
+    g = g < 0 ? 0 : g > 63 ? 63 : g;
+    b = b < 0 ? 0 : b > 31 ? 31 : b;
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static inline void unpack_565(uint16_t c, int out[3])
+{
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+static void bc1_palette(uint16_t c0, uint16_t c1, int palette[4][3])
+{
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+    for (int k = 0; k < 3; k++)
+    {
+        if (c0 > c1)
+        {
+            palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+            palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+        }
+        else
+        {
+            palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+            palette[3][k] = 0;
+        }
+    }
+}
+
+static uint32_t bc1_indices(int block[16][3], int palette[4][3], int colors, int *total_error)
+{
+    uint32_t indices = 0;
+    int total = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0, best_error = color_error(block[i], palette[0]);
+        for (int p = 1; p < colors; p++)
+        {
+            int e = color_error(block[i], palette[p]);
+            if (e < best_error)
+            {
+                best_error = e;
+                best = p;
+            }
+        }
+        indices |= (uint32_t)best << (i * 2);
+        total += best_error;
+    }
+    *total_error = total;
+    return indices;
+}
+
+// Endpoints at the extremes along the block's principal axis, then one
+// least squares refit of the endpoints to the chosen indices
+static void encode_bc1_block(int block[16][3], uint8_t *out)
+{
+    float mean[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++)
+        for (int k = 0; k < 3; k++)
+            mean[k] += block[i][k] / 16.0f;
+
+    float cov[6] = {0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 16; i++)
+    {
+        float d[3] = {block[i][0] - mean[0], block[i][1] - mean[1], block[i][2] - mean[2]};
+        cov[0] += d[0] * d[0];
+        cov[1] += d[0] * d[1];
+        cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1];
+        cov[4] += d[1] * d[2];
+        cov[5] += d[2] * d[2];
+    }
+
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[3] = {cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                         cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                         cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+        float length = sqrtf(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f)
+            break;
+        axis[0] = next[0] / length;
+        axis[1] = next[1] / length;
+        axis[2] = next[2] / length;
+    }
+
+    float lo = INFINITY, hi = -INFINITY;
+    for (int i = 0; i < 16; i++)
+    {
+        float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+        lo = t < lo ? t : lo;
+        hi = t > hi ? t : hi;
+    }
+    float e0[3], e1[3];
+    for (int k = 0; k < 3; k++)
+    {
+        e0[k] = mean[k] + axis[k] * hi;
+        e1[k] = mean[k] + axis[k] * lo;
+    }
+
+    uint16_t c0 = pack_565(e0), c1 = pack_565(e1);
+    int palette[4][3];
+    int error;
+    uint32_t indices = 0;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        if (c0 < c1)
+        {
+            uint16_t t = c0;
+            c0 = c1;
+            c1 = t;
+        }
+        if (c0 == c1)
+        {
+            indices = 0;
+            break;
+        }
+        bc1_palette(c0, c1, palette);
+        indices = bc1_indices(block, palette, 4, &error);
+        if (pass == 1)
+            break;
+
+        // solve for the endpoints that best reproduce the block with these weights
+        float aa = 0, bb = 0, ab = 0, ax[3] = {0, 0, 0}, bx[3] = {0, 0, 0};
+        static const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        for (int i = 0; i < 16; i++)
+        {
+            float a = weights[(indices >> (i * 2)) & 3], b = 1.0f - a;
+            aa += a * a;
+            bb += b * b;
+            ab += a * b;
+            for (int k = 0; k < 3; k++)
+            {
+                ax[k] += a * block[i][k];
+                bx[k] += b * block[i][k];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) < 1e-6f)
+            break;
+        float r0[3], r1[3];
+        for (int k = 0; k < 3; k++)
+        {
+            r0[k] = (ax[k] * bb - bx[k] * ab) / det;
+            r1[k] = (bx[k] * aa - ax[k] * ab) / det;
+        }
+        uint16_t n0 = pack_565(r0), n1 = pack_565(r1);
+        int refit_error;
+        int refit_palette[4][3];
+        if (n0 == n1)
+            break;
+        bc1_palette(n0 > n1 ? n0 : n1, n0 > n1 ? n1 : n0, refit_palette);
+        bc1_indices(block, refit_palette, 4, &refit_error);
+        if (refit_error >= error)
+            break;
+        c0 = n0;
+        c1 = n1;
+    }
+
+    out[0] = (uint8_t)(c0 & 0xFF);
+    out[1] = (uint8_t)(c0 >> 8);
+    out[2] = (uint8_t)(c1 & 0xFF);
+    out[3] = (uint8_t)(c1 >> 8);
+    memcpy(out + 4, &indices, 4);
+    if (c0 == c1)
+        memset(out + 4, 0, 4);
+}
+
+static void decode_bc1_block(const uint8_t *in, int block[16][3])
+{
+    uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8)), c1 = (uint16_t)(in[2] | (in[3] << 8));
+    uint32_t indices = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+    int palette[4][3];
+    bc1_palette(c0, c1, palette);
+    for (int i = 0; i < 16; i++)
+        memcpy(block[i], palette[(indices >> (i * 2)) & 3], sizeof(block[i]));
+}
+
+// ETC1, which every ETC2 decoder reads unchanged
+
+static const int etc_modifiers[8][2] = {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+
+// ETC numbers pixels down columns
+static inline int etc_pixel(int x, int y)
+{
+    return x * 4 + y;
+}
+
+static inline bool in_subblock(int x, int y, int flip, int sub)
+{
+    return flip ? (y >= 2) == (sub == 1) : (x >= 2) == (sub == 1);
+}
+
+// Best table and per pixel selectors for one half of the block around base
+static int etc_fit_subblock(int block[16][3], int flip, int sub, const int base[3], int *table, int selectors[16])
+{
+    int best_error = 0x7FFFFFFF;
+    for (int t = 0; t < 8; t++)
+    {
+        int error = 0;
+        int chosen[16];
+        for (int y = 0; y < 4; y++)
+        {
+            for (int x = 0; x < 4; x++)
+            {
+                if (!in_subblock(x, y, flip, sub))
+                    continue;
+                const int *pixel = block[y * 4 + x];
+                int best = 0, best_pixel_error = 0x7FFFFFFF;
+                for (int s = 0; s < 4; s++)
+                {
+                    int modifier = s & 2 ? -etc_modifiers[t][s & 1] : etc_modifiers[t][s & 1];
+                    int c[3] = {clamp255(base[0] + modifier), clamp255(base[1] + modifier), clamp255(base[2] + modifier)};
+                    int e = color_error(pixel, c);
+                    if (e < best_pixel_error)
+                    {
+                        best_pixel_error = e;
+                        best = s;
+                    }
+                }
+                chosen[etc_pixel(x, y)] = best;
+                error += best_pixel_error;
+            }
+        }
+        if (error < best_error)
+        {
+            best_error = error;
+            *table = t;
+            for (int y = 0; y < 4; y++)
+                for (int x = 0; x < 4; x++)
+                    if (in_subblock(x, y, flip, sub))
+                        selectors[etc_pixel(x, y)] = chosen[etc_pixel(x, y)];
+        }
+    }
+    return best_error;
+}
+
+static void encode_etc_block(int block[16][3], uint8_t *out)
+{
+    uint64_t best_bits = 0;
+    int best_error = 0x7FFFFFFF;
+
+    for (int flip = 0; flip < 2; flip++)
+    {
+        float average[2][3] = {{0, 0, 0}, {0, 0, 0}};
+        for (int y = 0; y < 4; y++)
+            for (int x = 0; x < 4; x++)
+                for (int k = 0; k < 3; k++)
+                    average[in_subblock(x, y, flip, 1)][k] += block[y * 4 + x][k] / 8.0f;
+
+        for (int differential = 0; differential < 2; differential++)
+        {
+            int quantized[2][3], base[2][3];
+            bool valid = true;
+            for (int sub = 0; sub < 2; sub++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    if (differential)
+                    {
+                        quantized[sub][k] = (int)(average[sub][k] * 31.0f / 255.0f + 0.5f);
+                        base[sub][k] = (quantized[sub][k] << 3) | (quantized[sub][k] >> 2);
+                    }
+                    else
+                    {
+                        quantized[sub][k] = (int)(average[sub][k] * 15.0f / 255.0f + 0.5f);
+                        base[sub][k] = quantized[sub][k] * 17;
+                    }
+                }
+            }
+            if (differential)
+                for (int k = 0; k < 3; k++)
+                    if (quantized[1][k] - quantized[0][k] < -4 || quantized[1][k] - quantized[0][k] > 3)
+                        valid = false;
+            if (!valid)
+                continue;
+
+            int tables[2], selectors[16];
+            int error = etc_fit_subblock(block, flip, 0, base[0], &tables[0], selectors) +
+                        etc_fit_subblock(block, flip, 1, base[1], &tables[1], selectors);
+            if (error >= best_error)
+                continue;
+
+            uint64_t bits = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                int shift = 56 - k * 8;
+                if (differential)
+                    bits |= (uint64_t)((quantized[0][k] << 3) | ((quantized[1][k] - quantized[0][k]) & 7)) << shift;
+                else
+                    bits |= (uint64_t)((quantized[0][k] << 4) | quantized[1][k]) << shift;
+            }
+            bits |= (uint64_t)tables[0] << 37 | (uint64_t)tables[1] << 34;
+            bits |= (uint64_t)differential << 33 | (uint64_t)flip << 32;
+            for (int i = 0; i < 16; i++)
+            {
+                bits |= (uint64_t)(selectors[i] >> 1) << (16 + i);
+                bits |= (uint64_t)(selectors[i] & 1) << i;
+            }
+            best_error = error;
+            best_bits = bits;
+        }
+    }
+
+    for (int i = 0; i < 8; i++)
+        out[i] = (uint8_t)(best_bits >> (56 - i * 8));
+}
+
+static void decode_etc_block(const uint8_t *in, int block[16][3])
+{
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++)
+        bits = (bits << 8) | in[i];
+
+    int differential = (bits >> 33) & 1, flip = (bits >> 32) & 1;
+    int base[2][3];
+    for (int k = 0; k < 3; k++)
+    {
+        int byte = (bits >> (56 - k * 8)) & 0xFF;
+        if (differential)
+        {
+            int c0 = byte >> 3, delta = byte & 7;
+            int c1 = c0 + (delta >= 4 ? delta - 8 : delta);
+            base[0][k] = (c0 << 3) | (c0 >> 2);
+            base[1][k] = (c1 << 3) | (c1 >> 2);
+        }
+        else
+        {
+            base[0][k] = (byte >> 4) * 17;
+            base[1][k] = (byte & 15) * 17;
+        }
+    }
+    int tables[2] = {(int)((bits >> 37) & 7), (int)((bits >> 34) & 7)};
+
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            int sub = in_subblock(x, y, flip, 1);
+            int i = etc_pixel(x, y);
+            int s = (int)(((bits >> (16 + i)) & 1) << 1 | ((bits >> i) & 1));
+            int modifier = s & 2 ? -etc_modifiers[tables[sub]][s & 1] : etc_modifiers[tables[sub]][s & 1];
+            for (int k = 0; k < 3; k++)
+                block[y * 4 + x][k] = clamp255(base[sub][k] + modifier);
+        }
+    }
+}
+
+void encode_texture(TextureFormat format, const uint8_t *rgb, uint32_t width, uint32_t height, uint8_t *out)
+{
+    if (format == TEXTURE_RGB8)
+    {
+        memcpy(out, rgb, (size_t)width * height * 3);
+        return;
+    }
+
+    int block[16][3];
+    for (uint32_t by = 0; by < (height + 3) / 4; by++)
+    {
+        for (uint32_t bx = 0; bx < (width + 3) / 4; bx++)
+        {
+            fetch_block(rgb, width, height, bx, by, block);
+            if (format == TEXTURE_BC1)
+                encode_bc1_block(block, out);
+            else
+                encode_etc_block(block, out);
+            out += 8;
+        }
+    }
+}
+
+void decode_texture(TextureFormat format, const uint8_t *data, uint32_t width, uint32_t height, uint8_t *rgb)
+{
+    if (format == TEXTURE_RGB8)
+    {
+        memcpy(rgb, data, (size_t)width * height * 3);
+        return;
+    }
+
+    int block[16][3];
+    for (uint32_t by = 0; by < (height + 3) / 4; by++)
+    {
+        for (uint32_t bx = 0; bx < (width + 3) / 4; bx++)
+        {
+            if (format == TEXTURE_BC1)
+                decode_bc1_block(data, block);
+            else
+                decode_etc_block(data, block);
+            store_block(rgb, width, height, bx, by, block);
+            data += 8;
+        }
+    }
+}
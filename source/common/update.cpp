@@ -5,17 +5,21 @@
 #include <vector>
 
 #include "aabb.hpp"
+#include "assets.hpp"
+#include "debug_draw.hpp"
+#include "frame_ring.hpp"
+#include "frustum.hpp"
 #include "impl_base.hpp"
-#include "line.hpp"
+#include "instancing.hpp"
 #include "model.hpp"
+#include "occlusion.hpp"
+#include "pack.hpp"
 #include "ray.hpp"
+#include "render_queue.hpp"
 #include "shader.hpp"
 #include "update.hpp"
 
-GLuint program_id;
-GLuint matrix_id;
-GLuint time_id;
-GLuint color_id;
+Program *color_program;
 
 glm::vec3 position = glm::vec3(.0f, 2.0f, 2.0f);
 float horizontal_angle = 3.15f;
@@ -23,18 +27,23 @@ float vertical_angle = -.2f;
 float speed = 5.0f;
 float mouse_speed = 0.1f;
 bool draw_boxes = false;
+bool occlusion_culling = true;
+int redraw_frames = REDRAW_FRAMES;
+// bumped by every change, occlusion results from an older scene may be stale
+static uint32_t scene = 1;
 
 glm::highp_mat4 projection;
-std::vector<Model *> models_imgui_draw_order;
-std::vector<Model *>::iterator models_mid_it;
 std::vector<Model *> models;
 std::vector<Model *> arrows;
 Model *selected_model = NULL;
+// the mouse ray, drawn with the boxes
+static glm::vec3 line_start = position;
+static glm::vec3 line_end = position;
 
-void sort_models()
+void mark_dirty()
 {
-    models_mid_it = std::partition(models.begin(), models.end(), [](Model *m)
-                                   { return m->color.a == 1.0f; });
+    redraw_frames = REDRAW_FRAMES;
+    scene++;
 }
 
 void graph_ops_init()
@@ -49,17 +58,22 @@ void graph_ops_init()
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
 
-    program_id = load_shaders("source/shaders/color.vert.glsl", "source/shaders/color.frag.glsl");
-    matrix_id = glGetUniformLocation(program_id, "u_mvp");
-    time_id = glGetUniformLocation(program_id, "u_time");
-    color_id = glGetUniformLocation(program_id, "u_color");
+    // one mapping instead of a file per asset, loose files are the fallback
+    pack_mount(GPK_DEFAULT_PATH);
+    assets_init();
 
-    models.push_back(Model::from_obj(matrix_id, color_id, "models/sphere.obj", "Sphere"));
-    models.push_back(Model::from_obj(matrix_id, color_id, "models/link.obj", "Link"));
+    // every program is only submitted here, they compile while assets load
+    color_program = request_program("source/shaders/color.vert.glsl", "source/shaders/color.frag.glsl", INSTANCED_DEFINES);
+    // the occlusion proxies are drawn one at a time
+    request_program("source/shaders/color.vert.glsl", "source/shaders/color.frag.glsl");
+    request_program("source/shaders/debug.vert.glsl", "source/shaders/debug.frag.glsl");
+
+    models.push_back(Model::from_obj(color_program, "models/sphere.obj", "Sphere"));
+    models.push_back(Model::from_obj(color_program, "models/link.obj", "Link"));
 
     selected_model = models[0];
 
-    models[0]->texture_from_file(0);
+    models[0]->texture_from_file("assets/earth.jpg");
 
     models[0]->color = glm::vec4(1.0f);
     models[0]->move_by(glm::vec3(0.0f, 0.0f, -2.5f));
@@ -67,14 +81,14 @@ void graph_ops_init()
     models[1]->move_by(glm::vec3(0.0f, -.5f, 0.0f));
     models[1]->color = glm::vec4(1.0f, 0.0f, 1.0f, 0.8f);
 
-    Model *base = Model::from_obj(matrix_id, color_id, "models/axis_arrow.obj", "Z axis arrow");
+    Model *base = Model::from_obj(color_program, "models/axis_arrow.obj", "Z axis arrow");
 
-    Model *x_axis_arrow = new Model(matrix_id, color_id, base->vertices, base->uvs, base->normals, "X axis arrow");
+    Model *x_axis_arrow = new Model(color_program, base->mesh, "X axis arrow");
     x_axis_arrow->color = glm::vec4(1.0f, .0f, 0.0f, 1.0f);
     x_axis_arrow->matrix = glm::rotate(x_axis_arrow->matrix, glm::radians(270.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     x_axis_arrow->rotation.z = 270.0f;
 
-    Model *y_axis_arrow = new Model(matrix_id, color_id, base->vertices, base->uvs, base->normals, "Y axis arrow");
+    Model *y_axis_arrow = new Model(color_program, base->mesh, "Y axis arrow");
     y_axis_arrow->color = glm::vec4(.0f, 1.0f, 0.0f, 1.0f);
 
     Model *z_axis_arrow = base;
@@ -91,17 +105,79 @@ void graph_ops_init()
     arrows.push_back(z_axis_arrow);
 
     update_model(models[0]);
-
-    sort_models();
-    models_imgui_draw_order = models;
 }
 
-void graph_ops_update(double ticks, double dt)
+static void draw_scene(glm::mat4 const &view_projection, Model *bullet)
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glUseProgram(program_id);
+    frame_ring_begin();
+
+    // only models inside the view and not hidden behind others are queued
+    static PackedBounds bounds;
+    static std::vector<uint32_t> in_view;
+    static std::vector<uint32_t> visible;
+    bounds.clear();
+    for (auto &model : models)
+        bounds.push(model->box);
+    cull_frustum(extract_frustum(view_projection), bounds, in_view);
+    if (occlusion_culling)
+    {
+        // keep drawing without a change until late results are in
+        if (occlusion_cull(models.data(), in_view, visible, position, scene) && redraw_frames < 1)
+            redraw_frames = 1;
+    }
+    else
+        visible = in_view;
+
+    // opaque models grouped by state, transparent ones back to front, arrows on top
+    static RenderQueue queue;
+    queue.clear();
+    queue.push(bullet, view_projection);
+    for (uint32_t index : visible)
+        queue.push(models[index], view_projection);
+    if (selected_model)
+    {
+        for (auto &arrow : arrows)
+            queue.push(arrow, view_projection, true);
+    }
+    queue.sort();
 
-    glUniform1f(time_id, ticks);
+    FrameConstants frame_constants = {view_projection};
+    frame_uniforms(FRAME_BLOCK_BINDING, &frame_constants, sizeof(FrameConstants));
+
+    queue.execute(RENDER_OPAQUE, RENDER_OPAQUE);
+    // tested against this frame's opaque depth, read back in a later frame
+    if (occlusion_culling)
+        occlusion_query(models.data(), in_view, view_projection, position, scene);
+    queue.execute(RENDER_TRANSPARENT, RENDER_OVERLAY);
+
+    if (draw_boxes)
+    {
+        debug_line(line_start, line_end);
+        for (auto &model : models)
+            debug_aabb(model->box);
+        for (auto &arrow : arrows)
+            debug_aabb(arrow->box, arrow->color);
+    }
+    debug_flush();
+    frame_ring_end();
+}
+
+bool graph_ops_update(double dt)
+{
+    // meshes and textures arrive a few at a time, placeholders until then
+    bool uploaded = upload_assets() > 0;
+    poll_programs();
+    if (uploaded)
+    {
+        for (auto &model : models)
+            model->refresh_box();
+        for (auto &arrow : arrows)
+            arrow->refresh_box();
+    }
+    // placeholders are swapped for the real thing any frame now
+    if (uploaded || assets_pending())
+        mark_dirty();
 
     glm::vec3 direction =
         glm::vec3(glm::cos(vertical_angle) * glm::sin(horizontal_angle),
@@ -145,10 +221,12 @@ void graph_ops_update(double ticks, double dt)
         glm::vec3 model_pos = glm::vec3(model->matrix[3].x, model->matrix[3].y, model->matrix[3].z);
         glm::vec3 dir = position - model_pos;
         dir.y = .0f;
+        glm::mat4 prev_matrix = model->matrix;
         model->matrix = glm::inverse(glm::lookAt(model_pos, position, up));
-        if (glm::abs(dir.x) < 1.5f && glm::abs(dir.z) < 1.5f)
-            continue;
-        model->move_by(glm::normalize(dir) * 2.0f * (float)dt);
+        if (glm::abs(dir.x) >= 1.5f || glm::abs(dir.z) >= 1.5f)
+            model->move_by(glm::normalize(dir) * 2.0f * (float)dt);
+        if (model->matrix != prev_matrix)
+            mark_dirty();
     }
 
     if (position.y < 0.0f)
@@ -157,50 +235,25 @@ void graph_ops_update(double ticks, double dt)
     static Model *bullet = 0;
     if (!bullet)
     {
-        bullet = new Model(matrix_id, color_id, models[0]->vertices, models[0]->uvs, models[0]->normals, models[0]->label);
+        bullet = new Model(color_program, models[0]->mesh, models[0]->label);
         bullet->matrix = glm::scale(bullet->matrix, glm::vec3(0.1f, 0.1f, 0.1f));
         bullet->color = glm::vec4(1.0f, 1.0f ,1.0f, 0.5f);
     }
-
-    bullet->draw(view_projection);
-
-    for (auto model_it = std::begin(models); model_it != models_mid_it; ++model_it)
+    else if (uploaded)
+        bullet->refresh_box();
+
+    // an unchanged view of an unchanged scene is already on screen
+    static glm::mat4 drawn_view_projection;
+    if (view_projection != drawn_view_projection)
+        mark_dirty();
+    bool draw = redraw_frames > 0;
+    if (draw)
     {
-        glUseProgram(program_id);
-        auto model = *model_it;
-        model->draw(view_projection);
+        redraw_frames--;
+        drawn_view_projection = view_projection;
+        draw_scene(view_projection, bullet);
     }
 
-    glUseProgram(program_id);
-
-    if (models_mid_it != std::end(models))
-    {
-        glDepthMask(GL_FALSE);
-        for (auto model_it = models_mid_it; model_it != std::end(models); ++model_it)
-        {
-            auto model = *model_it;
-            model->draw(view_projection);
-        }
-        glDepthMask(GL_TRUE);
-    }
-
-    glClear(GL_DEPTH_BUFFER_BIT);
-
-    if (selected_model)
-        for (const auto &arrow : arrows)
-            arrow->draw(view_projection);
-
-    static glm::vec3 line_start(position.x, position.y, position.z);
-    static glm::vec3 line_end(position.x, position.y, position.z);
-
-    auto mvp = view_projection * glm::mat4(1.0f);
-    glUniformMatrix4fv(matrix_id, 1, GL_FALSE, &mvp[0][0]);
-    glUniform4f(color_id, 1.0f, 1.0f, 1.0f, 1.0f);
-
-    static Line mouse_ray_line(line_start, line_end);
-    if (draw_boxes)
-        mouse_ray_line.draw();
-
     auto &x = arrows[0];
     auto &y = arrows[1];
     auto &z = arrows[2];
@@ -213,7 +266,6 @@ void graph_ops_update(double ticks, double dt)
         Ray mouse_ray;
         mouse_ray.origin = line_start = position;
         mouse_ray.direction = line_end = position + t * casted_ray;
-        mouse_ray_line.update(line_start, line_end);
         FastRay fast_ray = precompute_ray_inv(mouse_ray);
         if (selected_model)
         {
@@ -244,7 +296,9 @@ void graph_ops_update(double ticks, double dt)
             bullet->move_to(position + glm::normalize(casted_ray));
         else
             bullet->move_by(casted_ray / 6.0f);
+        mark_dirty();
     }
+    return draw;
 }
 
 void imgui_update()
@@ -285,6 +339,7 @@ void imgui_update()
                 selected_model->move_by(move);
                 for (auto &arrow : arrows)
                     arrow->move_by(move);
+                mark_dirty();
             }
         }
         prev_mouse = mouse;
@@ -299,36 +354,17 @@ void imgui_update()
     ImGui::SetNextWindowSize(ImVec2(280.0f, 280.0f), ImGuiCond_Once);
     ImGui::Begin("graph-ops");
 
-    ImGui::Checkbox("Draw Boxes", &draw_boxes);
-    if (draw_boxes)
-    {
-        if (selected_model)
-        {
-            static Box model_box(selected_model->box);
-            model_box.update(selected_model->box);
-            model_box.draw();
-        }
-
-        static Box x_arrow(arrows[0]->box);
-        x_arrow.update(arrows[0]->box);
-        x_arrow.draw();
-
-        static Box y_arrow(arrows[1]->box);
-        y_arrow.update(arrows[1]->box);
-        y_arrow.draw();
-
-        static Box z_arrow(arrows[2]->box);
-        z_arrow.update(arrows[2]->box);
-        z_arrow.draw();
-    }
+    if (ImGui::Checkbox("Draw Boxes", &draw_boxes))
+        mark_dirty();
+    if (ImGui::Checkbox("Occlusion Culling", &occlusion_culling))
+        mark_dirty();
 
     if (ImGui::Button("Copy Selected Model"))
     {
         const auto &base = selected_model ? selected_model : models[0];
-        Model *model = new Model(matrix_id, color_id, base->vertices, base->uvs, base->normals, base->label);
-        models_imgui_draw_order.push_back(model);
+        Model *model = new Model(color_program, base->mesh, base->label);
         models.push_back(model);
-        sort_models();
+        mark_dirty();
     }
 
     if (ImGui::CollapsingHeader("Position", ImGuiTreeNodeFlags_None))
@@ -340,9 +376,9 @@ void imgui_update()
         ImGui::SliderFloat("V", &vertical_angle, -4.0f, 4.0f);
     }
 
-    for (size_t i = 0; i < models_imgui_draw_order.size(); ++i)
+    for (size_t i = 0; i < models.size(); ++i)
     {
-        auto &model = models_imgui_draw_order[i];
+        auto &model = models[i];
         ImGui::PushID(i);
         ImGui::SetNextItemOpen(model == selected_model, ImGuiCond_Once);
         if (ImGui::CollapsingHeader(model->label, ImGuiTreeNodeFlags_None))
@@ -363,6 +399,7 @@ void imgui_update()
                     float radians = model->rotation.x < prev_x_rotation ? glm::radians(-(prev_x_rotation - model->rotation.x)) : glm::radians(model->rotation.x - prev_x_rotation);
                     model->matrix = glm::rotate(model->matrix, radians, glm::vec3(1.0f, 0.0f, 0.0f));
                     model->box = calc_transformed_bounds(model->original_box, model->matrix);
+                    mark_dirty();
                 }
             }
             if (ImGui::SliderFloat("Yr", &model->rotation.y, .0f, 360.0f))
@@ -372,6 +409,7 @@ void imgui_update()
                     float radians = model->rotation.y < prev_y_rotation ? glm::radians(-(prev_y_rotation - model->rotation.y)) : glm::radians(model->rotation.y - prev_y_rotation);
                     model->matrix = glm::rotate(model->matrix, radians, glm::vec3(0.0f, 1.0f, 0.0f));
                     model->box = calc_transformed_bounds(model->original_box, model->matrix);
+                    mark_dirty();
                 }
             }
             if (ImGui::SliderFloat("Zr", &model->rotation.z, .0f, 360.0f))
@@ -381,11 +419,11 @@ void imgui_update()
                     float radians = model->rotation.z < prev_z_rotation ? glm::radians(-(prev_z_rotation - model->rotation.z)) : glm::radians(model->rotation.z - prev_z_rotation);
                     model->matrix = glm::rotate(model->matrix, radians, glm::vec3(0.0f, 0.0f, 1.0f));
                     model->box = calc_transformed_bounds(model->original_box, model->matrix);
+                    mark_dirty();
                 }
             }
-            auto prev_alpha = model->color.a;
-            if (ImGui::ColorPicker4("Color", (float *)&model->color) && model->color.a != prev_alpha)
-                sort_models();
+            if (ImGui::ColorPicker4("Color", (float *)&model->color))
+                mark_dirty();
         }
         ImGui::PopID();
     }
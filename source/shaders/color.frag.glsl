@@ -4,10 +4,23 @@ precision highp float;
 
 out vec4 color;
 
-uniform float u_time;
-uniform vec4 u_color;
+#ifdef INSTANCED
+in vec4 v_color;
+#else
+// see ObjectConstants
+layout(std140) uniform Object
+{
+    mat4 u_mvp;
+    vec4 u_color;
+    float u_layer;
+};
+#endif
 
 void main()
 {
+#ifdef INSTANCED
+    color = v_color;
+#else
     color = u_color;
+#endif
 }
@@ -4,10 +4,34 @@ precision highp float;
 
 layout(location = 0) in vec3 a_pos;
 
-uniform mat4 u_mvp;
-uniform float u_time;
+#ifdef INSTANCED
+// per instance, see InstanceData
+layout(location = 3) in mat4 a_matrix;
+layout(location = 7) in vec4 a_color;
+
+// see FrameConstants
+layout(std140) uniform Frame
+{
+    mat4 u_view_projection;
+};
+
+out vec4 v_color;
+#else
+// see ObjectConstants
+layout(std140) uniform Object
+{
+    mat4 u_mvp;
+    vec4 u_color;
+    float u_layer;
+};
+#endif
 
 void main()
 {
+#ifdef INSTANCED
+    gl_Position = u_view_projection * a_matrix * vec4(a_pos, 1);
+    v_color = a_color;
+#else
     gl_Position = u_mvp * vec4(a_pos, 1);
+#endif
 }
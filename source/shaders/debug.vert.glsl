@@ -0,0 +1,21 @@
+#version 300 es
+
+precision highp float;
+
+layout(location = 0) in vec3 a_pos;
+// see DebugVertex
+layout(location = 1) in vec4 a_color;
+
+// see FrameConstants
+layout(std140) uniform Frame
+{
+    mat4 u_view_projection;
+};
+
+out vec4 v_color;
+
+void main()
+{
+    gl_Position = u_view_projection * vec4(a_pos, 1);
+    v_color = a_color;
+}
@@ -5,11 +5,25 @@ precision highp float;
 in vec2 uv;
 out vec4 color;
 
-uniform float u_time;
-uniform vec4 u_color;
-uniform sampler2D s;
+uniform highp sampler2DArray s;
+
+#ifdef INSTANCED
+flat in float v_layer;
+#else
+// see ObjectConstants
+layout(std140) uniform Object
+{
+    mat4 u_mvp;
+    vec4 u_color;
+    float u_layer;
+};
+#endif
 
 void main()
 {
-    color = texture(s, uv);
+#ifdef INSTANCED
+    color = texture(s, vec3(uv, v_layer));
+#else
+    color = texture(s, vec3(uv, u_layer));
+#endif
 }
@@ -7,11 +7,35 @@ layout(location = 1) in vec2 a_uv;
 
 out vec2 uv;
 
-uniform mat4 u_mvp;
-uniform float u_time;
+#ifdef INSTANCED
+// per instance, see InstanceData
+layout(location = 3) in mat4 a_matrix;
+layout(location = 8) in float a_layer;
+
+// see FrameConstants
+layout(std140) uniform Frame
+{
+    mat4 u_view_projection;
+};
+
+flat out float v_layer;
+#else
+// see ObjectConstants
+layout(std140) uniform Object
+{
+    mat4 u_mvp;
+    vec4 u_color;
+    float u_layer;
+};
+#endif
 
 void main()
 {
+#ifdef INSTANCED
+    gl_Position = u_view_projection * a_matrix * vec4(a_pos, 1);
+    v_layer = a_layer;
+#else
     gl_Position = u_mvp * vec4(a_pos, 1);
+#endif
     uv = a_uv;
 }
@@ -0,0 +1,210 @@
+// Compiles shaders, meshes and textures into a source file of constexpr
+// arrays so the binary needs nothing from disk, or into a .gpk pack when
+// the output ends in .gpk. OBJ files are stored as their .gom cache and
+// images as a .gtx cache per -t format, everything else as is. Images are
+// stored as well, decoded when the context samples none of the formats.
+//
+//     make embed-assets
+//     ./embed-assets -t etc2 -t bc1 source/generated/embedded_assets.cpp models/*.obj assets/*.jpg source/shaders/*.glsl
+//     ./embed-assets -t bc1 assets.gpk models/*.obj assets/*.jpg source/shaders/*.glsl
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "gtx.hpp"
+#include "mesh_data.hpp"
+#include "pack.hpp"
+
+struct Entry
+{
+    std::string key;  // path the loaders ask for
+    std::string file; // where the bytes are read from
+};
+
+static bool ends_with(std::string const &s, const char *suffix)
+{
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static bool build_texture(const char *path, TextureFormat format, std::string const &cache_path)
+{
+    GomSource source;
+    if (!gom_source_info(path, source))
+    {
+        error("could not stat %s", path);
+        return false;
+    }
+
+    GtxTexture gtx;
+    if (gtx_open(cache_path.c_str(), path, source, format, gtx))
+    {
+        gtx_close(gtx);
+        return true;
+    }
+
+    File file = open_and_map_file(path, IO_READ_ONLY);
+    source.hash = gom_hash(file.start, file.size);
+    int width, height, channels;
+    stbi_uc *pixels = stbi_load_from_memory(file.start, (int)file.size, &width, &height, &channels, 3);
+    UNMAP_AND_CLOSE_FILE(file);
+    if (!pixels)
+    {
+        error("could not decode %s: %s", path, stbi_failure_reason());
+        return false;
+    }
+
+    std::vector<TextureLevel> levels;
+    build_mips(pixels, width, height, levels);
+    stbi_image_free(pixels);
+    if (!gtx_write(cache_path.c_str(), source, format, levels))
+    {
+        error("could not write %s", cache_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void write_array(FILE *out, size_t index, std::string const &path)
+{
+    File file = open_and_map_file(path.c_str(), IO_READ_ONLY);
+    // 16-byte aligned like the caches on disk, so streams can be read in place
+    fprintf(out, "alignas(16) static constexpr uint8_t file_%zu[] = {", index);
+    for (size_t i = 0; i < file.size; i++)
+        fprintf(out, "%s%u,", i % 24 == 0 ? "\n    " : "", file.start[i]);
+    fprintf(out, "\n};\n\n");
+    UNMAP_AND_CLOSE_FILE(file);
+}
+
+static bool write_pack(const char *output, std::vector<Entry> const &entries)
+{
+    std::vector<File> files;
+    std::vector<PackInput> inputs;
+    for (auto const &entry : entries)
+    {
+        File file = open_and_map_file(entry.file.c_str(), IO_READ_ONLY);
+        files.push_back(file);
+        // caches are read in place, only loose files are worth inflating
+        bool cache = ends_with(entry.file, ".gom") || ends_with(entry.file, ".gtx");
+        inputs.push_back({entry.key, file.start, file.size, !cache});
+    }
+
+    bool written = pack_write(output, inputs);
+    for (auto &file : files)
+        UNMAP_AND_CLOSE_FILE(file);
+    if (!written)
+    {
+        error("could not write %s", output);
+        return false;
+    }
+
+    size_t raw = 0;
+    for (auto const &input : inputs)
+        raw += input.size;
+    File pack = open_and_map_file(output, IO_READ_ONLY);
+    printf("Packed %zu files into %s: %zu bytes from %zu\n", entries.size(), output, pack.size, raw);
+    UNMAP_AND_CLOSE_FILE(pack);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<TextureFormat> formats;
+    int arg = 1;
+    while (arg + 1 < argc && strcmp(argv[arg], "-t") == 0)
+    {
+        const char *name = argv[arg + 1];
+        if (strcmp(name, "rgb8") == 0)
+            formats.push_back(TEXTURE_RGB8);
+        else if (strcmp(name, "bc1") == 0)
+            formats.push_back(TEXTURE_BC1);
+        else if (strcmp(name, "etc2") == 0)
+            formats.push_back(TEXTURE_ETC2);
+        else
+        {
+            error("unknown texture format %s", name);
+            return 1;
+        }
+        arg += 2;
+    }
+    if (formats.empty())
+        formats.push_back(TEXTURE_BC1);
+    if (arg >= argc)
+    {
+        printf("usage: %s [-t rgb8|bc1|etc2]... output.cpp|output.gpk files...\n", argv[0]);
+        return 1;
+    }
+    const char *output = argv[arg++];
+
+    std::vector<Entry> entries;
+    for (; arg < argc; arg++)
+    {
+        std::string path = argv[arg];
+        if (ends_with(path, ".obj"))
+        {
+            // writes or refreshes path.gom
+            MeshData data;
+            if (!read_mesh_data(path.c_str(), MESH_DEFAULT_FLAGS, data))
+                return 1;
+            entries.push_back({path + ".gom", path + ".gom"});
+        }
+        else if (ends_with(path, ".jpg") || ends_with(path, ".png"))
+        {
+            for (TextureFormat format : formats)
+            {
+                std::string cache_path = gtx_cache_path(path.c_str(), format);
+                if (!build_texture(path.c_str(), format, cache_path))
+                    return 1;
+                entries.push_back({cache_path, cache_path});
+            }
+            entries.push_back({path, path});
+        }
+        else
+            entries.push_back({path, path});
+    }
+
+    if (ends_with(output, ".gpk"))
+        return write_pack(output, entries) ? 0 : 1;
+
+    // find_embedded binary searches by path
+    std::sort(entries.begin(), entries.end(), [](Entry const &a, Entry const &b)
+              { return strcmp(a.key.c_str(), b.key.c_str()) < 0; });
+
+    std::string temp_path = std::string(output) + ".tmp";
+    FILE *out = fopen(temp_path.c_str(), "w");
+    if (!out)
+    {
+        error("could not open %s: %s", temp_path.c_str(), strerror(errno));
+        return 1;
+    }
+
+    fprintf(out, "// Generated by tools/embed_assets.cpp, do not edit\n\n#include \"embedded.hpp\"\n\n");
+    for (size_t i = 0; i < entries.size(); i++)
+        write_array(out, i, entries[i].file);
+
+    fprintf(out, "const EmbeddedFile embedded_files[] = {\n");
+    for (size_t i = 0; i < entries.size(); i++)
+        fprintf(out, "    {\"%s\", file_%zu, sizeof(file_%zu)},\n", entries[i].key.c_str(), i, i);
+    if (entries.empty())
+        fprintf(out, "    {},\n");
+    fprintf(out, "};\nconst size_t embedded_file_count = %zu;\n", entries.size());
+
+    if (fclose(out) != 0)
+    {
+        remove(temp_path.c_str());
+        return 1;
+    }
+    // only touch the output when it's complete so make never sees half a file
+    remove(output);
+    if (rename(temp_path.c_str(), output) != 0)
+    {
+        error("could not write %s: %s", output, strerror(errno));
+        return 1;
+    }
+    printf("Embedded %zu files into %s\n", entries.size(), output);
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Builds the .gtx texture caches ahead of time so the first run skips the
+// encode. Builds that embed assets make their own with embed-assets.
+//
+//     make gtx-build
+//     ./gtx-build assets/earth.jpg
+
+#include <chrono>
+#include <math.h>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "gtx.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+static double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double psnr(const uint8_t *a, const uint8_t *b, size_t size)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < size; i++)
+    {
+        double d = (double)a[i] - b[i];
+        sum += d * d;
+    }
+    return sum > 0.0 ? 10.0 * log10(255.0 * 255.0 * size / sum) : 99.0;
+}
+
+static bool build(const char *path, TextureFormat format)
+{
+    GomSource source;
+    if (!gom_source_info(path, source))
+    {
+        error("could not stat %s", path);
+        return false;
+    }
+
+    File file = open_and_map_file(path, IO_READ_ONLY);
+    source.hash = gom_hash(file.start, file.size);
+    int width, height, channels;
+    stbi_uc *pixels = stbi_load_from_memory(file.start, (int)file.size, &width, &height, &channels, 3);
+    UNMAP_AND_CLOSE_FILE(file);
+    if (!pixels)
+    {
+        error("could not decode %s: %s", path, stbi_failure_reason());
+        return false;
+    }
+
+    auto start = Clock::now();
+    std::vector<TextureLevel> levels;
+    build_mips(pixels, width, height, levels);
+    stbi_image_free(pixels);
+
+    std::string cache_path = gtx_cache_path(path, format);
+    GtxTexture gtx;
+    if (!gtx_write(cache_path.c_str(), source, format, levels) || !gtx_open(cache_path.c_str(), path, source, format, gtx))
+    {
+        error("could not write %s", cache_path.c_str());
+        return false;
+    }
+
+    size_t size = 0;
+    for (uint32_t i = 0; i < gtx.header->level_count; i++)
+        size += gtx.header->levels[i].size;
+    std::vector<uint8_t> decoded(levels[0].pixels.size());
+    decode_texture(format, gtx_level_data(gtx, 0), width, height, decoded.data());
+
+    // what the old upload cost: RGB8 without mips, stored as RGBA8 by most drivers
+    size_t uncompressed = (size_t)width * height * 4;
+    printf("%s: %u levels, %.2f MB (%.1fx smaller than RGBA8), PSNR %.2f dB, %.0f ms\n", cache_path.c_str(),
+           gtx.header->level_count, size / (1024.0 * 1024.0), (double)uncompressed / size,
+           psnr(levels[0].pixels.data(), decoded.data(), decoded.size()), ms_since(start));
+    gtx_close(gtx);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: %s image...\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    for (int i = 1; i < argc; i++)
+    {
+        ok = build(argv[i], TEXTURE_BC1) && ok;
+        ok = build(argv[i], TEXTURE_ETC2) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+// Measures OBJ parsing throughput of the mapped parser, serial and across
+// all cores, against the old fscanf loop.
+//
+//     make obj-bench
+//     ./obj-bench models/sphere.obj
+//     ./obj-bench --generate big.obj 2000 && ./obj-bench big.obj
+
+#include <chrono>
+#include <math.h>
+#include <vector>
+
+#include "io.hpp"
+#include "obj.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+static double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// The loader Model::from_obj used before the mapped parser, kept as a baseline
+static bool fscanf_load(const char *path, std::vector<glm::vec3> &vertices)
+{
+    std::vector<unsigned int> vertex_indices;
+    std::vector<glm::vec3> temp_vertices;
+    std::vector<glm::vec2> temp_uvs;
+    std::vector<glm::vec3> temp_normals;
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return false;
+
+    while (1)
+    {
+        char header[128];
+        if (fscanf(file, "%127s", header) == EOF)
+            break;
+
+        if (strcmp(header, "v") == 0)
+        {
+            glm::vec3 vertex;
+            if (fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z) != 3)
+                break;
+            temp_vertices.push_back(vertex);
+        }
+        else if (strcmp(header, "vt") == 0)
+        {
+            glm::vec2 uv;
+            if (fscanf(file, "%f %f\n", &uv.x, &uv.y) != 2)
+                break;
+            temp_uvs.push_back(uv);
+        }
+        else if (strcmp(header, "vn") == 0)
+        {
+            glm::vec3 normal;
+            if (fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z) != 3)
+                break;
+            temp_normals.push_back(normal);
+        }
+        else if (strcmp(header, "f") == 0)
+        {
+            unsigned int v[3], vt[3], vn[3];
+            if (fscanf(file, "%u/%u/%u %u/%u/%u %u/%u/%u\n", &v[0], &vt[0], &vn[0], &v[1], &vt[1], &vn[1], &v[2], &vt[2], &vn[2]) != 9)
+            {
+                fclose(file);
+                return false;
+            }
+            vertex_indices.insert(vertex_indices.end(), v, v + 3);
+        }
+        else
+        {
+            char rest[1000];
+            if (!fgets(rest, sizeof(rest), file))
+                break;
+        }
+    }
+    fclose(file);
+
+    vertices.clear();
+    for (auto index : vertex_indices)
+        vertices.push_back(temp_vertices[index - 1]);
+    return true;
+}
+
+static void generate(const char *path, int segments)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        error("could not create %s", path);
+        exit(1);
+    }
+
+    int rings = segments / 2;
+    for (int r = 0; r <= rings; r++)
+    {
+        float phi = 3.14159265f * r / rings;
+        for (int s = 0; s <= segments; s++)
+        {
+            float theta = 2.0f * 3.14159265f * s / segments;
+            float x = sinf(phi) * cosf(theta), y = cosf(phi), z = sinf(phi) * sinf(theta);
+            fprintf(file, "v %f %f %f\n", x, y, z);
+            fprintf(file, "vt %f %f\n", (float)s / segments, (float)r / rings);
+            fprintf(file, "vn %f %f %f\n", x, y, z);
+        }
+    }
+
+    for (int r = 0; r < rings; r++)
+    {
+        for (int s = 0; s < segments; s++)
+        {
+            int a = r * (segments + 1) + s + 1, b = a + segments + 1;
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, a + 1, a + 1, a + 1);
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a + 1, a + 1, a + 1, b, b, b, b + 1, b + 1, b + 1);
+        }
+    }
+
+    fclose(file);
+}
+
+static void bench(const char *path)
+{
+    File file = open_and_map_file(path, IO_READ_ONLY);
+    double mb = file.size / 1e6;
+
+    auto start = Clock::now();
+    ObjData obj;
+    bool ok = parse_obj(file.start, file.size, obj);
+    double mapped_ms = ms_since(start);
+
+    start = Clock::now();
+    ObjData parallel;
+    bool parallel_ok = parse_obj_parallel(file.start, file.size, parallel);
+    double parallel_ms = ms_since(start);
+    UNMAP_AND_CLOSE_FILE(file);
+
+    if (!ok || !parallel_ok)
+    {
+        error("%s: parse failed", path);
+        return;
+    }
+
+    bool identical = parallel.positions.size() == obj.positions.size() &&
+                     parallel.uvs.size() == obj.uvs.size() &&
+                     parallel.normals.size() == obj.normals.size() &&
+                     parallel.corners.size() == obj.corners.size() &&
+                     !memcmp(parallel.positions.data(), obj.positions.data(), obj.positions.size() * sizeof(glm::vec3)) &&
+                     !memcmp(parallel.uvs.data(), obj.uvs.data(), obj.uvs.size() * sizeof(glm::vec2)) &&
+                     !memcmp(parallel.normals.data(), obj.normals.data(), obj.normals.size() * sizeof(glm::vec3)) &&
+                     !memcmp(parallel.corners.data(), obj.corners.data(), obj.corners.size() * sizeof(ObjCorner));
+
+    start = Clock::now();
+    std::vector<glm::vec3> reference;
+    bool reference_ok = fscanf_load(path, reference);
+    double fscanf_ms = ms_since(start);
+
+    size_t mismatches = 0;
+    if (!reference_ok || reference.size() != obj.corners.size())
+        mismatches = (size_t)-1;
+    else
+        for (size_t i = 0; i < reference.size(); i++)
+            mismatches += memcmp(&reference[i], &obj.positions[obj.corners[i].v], sizeof(glm::vec3)) != 0;
+
+    printf("%s: %.2f MB, %zu vertices, %zu triangles\n", path, mb, obj.positions.size(), obj.corners.size() / 3);
+    printf("  fscanf  %9.2f ms %8.1f MB/s\n", fscanf_ms, mb / fscanf_ms * 1e3);
+    printf("  mapped  %9.2f ms %8.1f MB/s (%.1fx)\n", mapped_ms, mb / mapped_ms * 1e3, fscanf_ms / mapped_ms);
+    printf("  threads %9.2f ms %8.1f MB/s (%.1fx)%s\n", parallel_ms, mb / parallel_ms * 1e3, fscanf_ms / parallel_ms,
+           identical ? "" : " OUTPUT DIFFERS FROM SERIAL");
+    if (mismatches == (size_t)-1)
+        printf("  fscanf loader could not read this file\n");
+    else if (mismatches)
+        printf("  %zu positions differ from fscanf\n", mismatches);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 4 && strcmp(argv[1], "--generate") == 0)
+    {
+        generate(argv[2], atoi(argv[3]));
+        return 0;
+    }
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s file.obj...\n       %s --generate out.obj segments\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++)
+        bench(argv[i]);
+
+    return 0;
+}